@@ -233,6 +233,7 @@ module COMET68k_CPLD(
         .n_as(n_as),
         .n_uds(n_uds),
         .n_lds(n_lds),
+        .n_write(n_write),
         .fc(fc),
         .n_eth_bg(n_eth_bg),
         .n_ras0(n_ras0),
@@ -680,9 +681,30 @@ endmodule /* xbus_machine */
  *
  * The DRAM machine decodes address 0-0x3FFFFF as long as boot_ff, which indicates that the CPU
  * has begun executing code after fetching the ISP and IPC values, is set. Otherwise it lays
- * dormant and does not perform any function other than refresh. */
+ * dormant and does not perform any function other than refresh.
+ *
+ * The TC5118180 needs 1024 refresh cycles every 16ms, one every 15.625uS on average. The refresh
+ * timer counts from REFRESH_CLOCKS down to 0 inclusive, so a refresh falls due every
+ * REFRESH_CLOCKS + 1 clocks: 620 clocks (15.5uS) leaves a little time in each 16ms for refreshes
+ * which have to wait for an access to finish.
+ *
+ * A refresh which is due is not performed straight away, as a DRAM access arriving during it would
+ * have to wait for it and the precharge after it. Instead it waits for the CPU (or another bus
+ * master) to start a read cycle that does not access DRAM, such as a ROM, X-bus, Ethernet or
+ * expansion bus read, or an interrupt acknowledge, and is performed alongside it. A refresh takes
+ * about 8 clocks, which is less than the remainder of even the shortest of those cycles, so it is
+ * over before the next cycle begins. If no such cycle comes along within REFRESH_GRACE_CLOCKS of
+ * the refresh falling due, it is performed as soon as the machine is idle. A forced refresh still
+ * has 120 clocks (3uS) to start before the next one falls due, far longer than any DRAM cycle it
+ * might have to wait for.
+ *
+ * WE/ of the DRAM modules follows R/W, and a CAS before RAS cycle with WE/ low is a WCBR cycle,
+ * which puts the TC5118180 into its test mode. So a refresh is never hidden behind a write, a
+ * forced refresh waits for R/W to be high, and RAS/ is held back, with CAS/ negated again, if
+ * R/W goes low in the clock between CAS/ and RAS/. */
 module dram_machine
-#(parameter REFRESH_CLOCKS=625,
+#(parameter REFRESH_CLOCKS=619,
+            REFRESH_GRACE_CLOCKS=500,
             REFRESH_WAIT_STATES=3,
             ACCESS_RAS_WAIT_STATES=1,
             ACCESS_CAS_WAIT_STATES=2,
@@ -694,6 +716,7 @@ module dram_machine
     input n_as,
     input n_uds,
     input n_lds,
+    input n_write,
     input [2:0] fc,
     input n_eth_bg,
     output logic n_ras0,
@@ -716,6 +739,7 @@ module dram_machine
     /* DRAM refresh timer */
     reg [9:0] dram_refresh_timer;
     reg refresh_due;
+    reg refresh_forced;
     
     /* Counter used throughout the machine to time various delays */
     reg [1:0] delay;
@@ -734,6 +758,7 @@ module dram_machine
         m_state = M_IDLE;
         dram_refresh_timer = REFRESH_CLOCKS;
         refresh_due = 1'b0;
+        refresh_forced = 1'b0;
         delay = 'd0;
         por_delay = 1'b0;
     end
@@ -742,6 +767,10 @@ module dram_machine
      * and the function code is not 7 */
     wire permitted_access = (n_eth_bg && (fc != 3'b111) || !n_eth_bg);
     
+    /* A cycle which accesses DRAM, and a read cycle which does not and can hide a refresh */
+    wire dram_cycle = (boot_ff && !n_as && (addr[23:22] == 2'b00) && permitted_access);
+    wire other_cycle = (!n_as && n_write && !dram_cycle);
+    
     always_comb begin
         /* Assert DTACK/ when ever the machine is in the CAS portion of a cycle */
         n_dtack = !(m_state == M_ACCESS_CAS && delay == 'd0);
@@ -769,15 +798,19 @@ module dram_machine
             end
         end
         
+        /* Force a refresh which has not been hidden by its deadline */
+        if (refresh_due && (dram_refresh_timer == REFRESH_CLOCKS - REFRESH_GRACE_CLOCKS)) begin
+            refresh_forced <= 1'b1;
+        end
+        
         case (m_state)
             /* In the idle state, the machine is waiting for either a memory access cycle from an
-             * external device, or the refresh_due flag to be set to perform a refresh cycle. */
+             * external device, or a read cycle which does not access DRAM to perform a refresh
+             * cycle that is due alongside. A refresh that is overdue is performed as soon as R/W
+             * is high. */
             M_IDLE:
-                if (refresh_due) begin
-                    /* Refresh cycle to be performed */
-                    refresh_due <= 1'b0;
-                    
-                    /* Assert CAS to both DRAM modules */
+                if (refresh_due && (other_cycle || refresh_forced && n_write)) begin
+                    /* Refresh cycle to be performed. Assert CAS to both DRAM modules */
                     n_ucas <= 1'b0;
                     n_lcas <= 1'b0;
                     
@@ -785,7 +818,7 @@ module dram_machine
                     delay <= REFRESH_WAIT_STATES;
                     m_state <= M_REFRESH_RAS;
                 end
-                else if (boot_ff && !n_as && (addr[23:22] == 2'b00) && permitted_access) begin
+                else if (dram_cycle) begin
                     /* Memory access cycle - assert RAS according to DRAM bank */
                     if (addr[21] == 1'b0) begin
                         /* DRAM module 0 if A21 is low */
@@ -814,8 +847,22 @@ module dram_machine
                     delay <= PRECHARGE_WAIT_STATES;
                     m_state <= M_PRECHARGE;
                 end
+                else if (n_ras0 && !n_write) begin
+                    /* R/W has gone low before RAS was asserted. Back off rather than start a WCBR
+                     * cycle, and try again once R/W is high. */
+                    n_ucas <= 1'b1;
+                    n_lcas <= 1'b1;
+                    
+                    m_state <= M_IDLE;
+                end
                 else begin
-                    /* Assert RAS to both DRAM modules while delaying */
+                    /* Assert RAS to both DRAM modules while delaying. The refresh is no longer
+                     * due once RAS is asserted. */
+                    if (n_ras0) begin
+                        refresh_due <= 1'b0;
+                        refresh_forced <= 1'b0;
+                    end
+                    
                     n_ras0 <= 1'b0;
                     n_ras1 <= 1'b0;
                     
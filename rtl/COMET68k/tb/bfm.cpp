@@ -0,0 +1,304 @@
+/* 68000 bus functional model, see bfm.h */
+
+#include "bfm.h"
+
+/* The E clock is a tenth of the CPU clock, low for 6 clocks and high for 4 */
+#define E_PERIOD 10
+#define E_RISE 6
+
+bfm::bfm(Vtb_top *top)
+    : top_(top), time_(0), clocks_(0), e_phase_(0), pre_()
+{
+    top_->osc_40mhz = 0;
+    top_->n_reset = 1;
+    top_->addr = 0;
+    top_->n_as = 1;
+    top_->n_uds = 1;
+    top_->n_lds = 1;
+    top_->n_write = 1;
+    top_->fc = 0;
+    top_->n_ext_dtack = 1;
+    top_->eth_das = 0;
+    top_->eth_ready = 0;
+    top_->nmi = 0;
+    top_->n_irq7 = 1;
+    top_->n_irq6 = 1;
+    top_->uart_irq = 0;
+    top_->n_irq5 = 1;
+    top_->n_eth_irq = 1;
+    top_->n_irq4 = 1;
+    top_->n_irq3 = 1;
+    top_->n_irq2 = 1;
+    top_->n_irq1 = 1;
+    top_->n_timer_irq = 1;
+    top_->soft_irq = 0;
+    top_->n_autovec = 1;
+    top_->n_bg = 1;
+    top_->n_eth_br = 1;
+    top_->n_br0 = 1;
+    top_->n_br1 = 1;
+    top_->eval();
+}
+
+void
+bfm::step()
+{
+    pre_.dtack = !top_->n_dtack;
+    pre_.berr = !top_->n_berr;
+    pre_.vpa = !top_->n_vpa;
+    pre_.ready = !top_->n_eth_ready;
+    pre_.br = !top_->n_br;
+
+    top_->osc_40mhz = !top_->osc_40mhz;
+    top_->eval();
+    time_ += OSC_HALF_PS;
+
+    if (on_eval) {
+        on_eval();
+    }
+}
+
+/* Run to the next rising or falling edge of the CPU clock */
+void
+bfm::rise()
+{
+    while (top_->cpu_clk) {
+        step();
+    }
+
+    while (!top_->cpu_clk) {
+        step();
+    }
+
+    clocks_++;
+    e_phase_ = (e_phase_ + 1) % E_PERIOD;
+}
+
+void
+bfm::fall()
+{
+    while (!top_->cpu_clk) {
+        step();
+    }
+
+    while (top_->cpu_clk) {
+        step();
+    }
+}
+
+void
+bfm::reset(uint32_t clocks)
+{
+    top_->n_reset = 0;
+    idle(clocks);
+    top_->n_reset = 1;
+    rise();
+}
+
+void
+bfm::idle(uint32_t clocks)
+{
+    while (clocks--) {
+        rise();
+    }
+}
+
+result
+bfm::cycle(const transfer &a, master m)
+{
+    result r = { ending::timeout, 0, 0 };
+    uint64_t start;
+    bool upper = a.size == 2 || !(a.addr & 1);
+    bool lower = a.size == 2 || (a.addr & 1);
+
+    /* Cycles start on the rising edge which the last one ended with */
+    start = clocks_;
+
+    /* S0: function code, and R/W high */
+    top_->fc = a.fc;
+    top_->n_write = 1;
+
+    /* S1: address */
+    fall();
+    top_->addr = (a.addr >> 1) & 0x7FFFFF;
+
+    /* S2: AS/, and the data strobes of a read. R/W low for a write. */
+    rise();
+    top_->n_as = 0;
+
+    if (m == master::ethernet) {
+        top_->eth_das = 1;
+    }
+
+    if (a.write) {
+        top_->n_write = 0;
+    } else {
+        top_->n_uds = !upper;
+        top_->n_lds = !lower;
+    }
+
+    /* S3: data out for a write */
+    fall();
+
+    /* S4: the data strobes of a write */
+    rise();
+
+    if (a.write) {
+        top_->n_uds = !upper;
+        top_->n_lds = !lower;
+    }
+
+    /* End of S4, and of each wait state */
+    for (;;) {
+        fall();
+
+        if (m == master::ethernet) {
+            if (pre_.ready) {
+                r.end = ending::dtack;
+                break;
+            }
+        } else if (pre_.berr) {
+            r.end = ending::berr;
+            break;
+        } else if (pre_.dtack) {
+            r.end = ending::dtack;
+            break;
+        } else if (pre_.vpa && m == master::cpu) {
+            r.end = ending::vpa;
+            break;
+        }
+
+        if (r.waits == TIMEOUT) {
+            break;
+        }
+
+        rise();
+        r.waits++;
+    }
+
+    /* A VPA/ cycle waits for E to go high and then low again */
+    if (r.end == ending::vpa) {
+        while (e_phase_ != E_RISE) {
+            rise();
+            fall();
+            r.waits++;
+        }
+
+        while (e_phase_ != 0) {
+            rise();
+            fall();
+            r.waits++;
+        }
+    }
+
+    /* S5 and S6: data latched at the end of S6 */
+    rise();
+
+    /* S7: strobes negated */
+    fall();
+    top_->n_as = 1;
+    top_->n_uds = 1;
+    top_->n_lds = 1;
+    top_->eth_das = 0;
+
+    /* The address is left as it was, and R/W returns high in S0 of the next cycle */
+    rise();
+    top_->n_write = 1;
+    r.clocks = clocks_ - start;
+
+    return r;
+}
+
+result
+bfm::iack(uint8_t level)
+{
+    /* A23-A4 are all high, and the level is given on A3-A1. The vector is read on the lower half
+     * of the data bus. */
+    transfer a = { 0xFFFFF1u | (uint32_t)(level << 1), 1, false, FC_CPU_SPACE };
+
+    return cycle(a);
+}
+
+bool
+bfm::granted(master m) const
+{
+    switch (m) {
+        case master::ethernet:
+            return !top_->n_eth_bg;
+
+        case master::card0:
+            return !top_->n_bg0;
+
+        case master::card1:
+            return !top_->n_bg1;
+
+        default:
+            return true;
+    }
+}
+
+void
+bfm::set_request(master m, bool req)
+{
+    switch (m) {
+        case master::ethernet:
+            top_->n_eth_br = !req;
+            break;
+
+        case master::card0:
+            top_->n_br0 = !req;
+            break;
+
+        case master::card1:
+            top_->n_br1 = !req;
+            break;
+
+        default:
+            break;
+    }
+}
+
+uint32_t
+bfm::request(master m)
+{
+    uint64_t start = clocks_;
+
+    set_request(m, true);
+
+    /* The 68000 samples BR/ on falling edges, and grants the bus on the next rising edge, as no
+     * cycle is in progress */
+    while (!granted(m)) {
+        fall();
+
+        if (pre_.br) {
+            rise();
+            top_->n_bg = 0;
+        } else {
+            rise();
+        }
+
+        if (clocks_ - start >= TIMEOUT) {
+            set_request(m, false);
+
+            return TIMEOUT;
+        }
+    }
+
+    return clocks_ - start;
+}
+
+void
+bfm::release(master m)
+{
+    uint64_t start = clocks_;
+
+    set_request(m, false);
+
+    /* Take the bus back once the arbiter has withdrawn the grant and BR/ */
+    while ((granted(m) || !top_->n_br) && clocks_ - start < TIMEOUT) {
+        rise();
+    }
+
+    top_->n_bg = 1;
+    rise();
+}
@@ -0,0 +1,122 @@
+/* 68000 bus functional model for the COMET68k_CPLD testbench
+ *
+ * Drives the bus of tb_top as a 68000 does, state by state (S0-S7, each half a CPU clock), from
+ * the cpu_clk that the CPLD itself produces. DTACK/, BERR/ and VPA/ are sampled as they were just
+ * before the falling edge at the end of S4, and at each falling edge after it, with a wait state
+ * of one clock inserted each time none of them is asserted. Cycles terminated by VPA/ are
+ * stretched to the next E clock, as the 68000 does for autovectors.
+ *
+ * The same engine runs cycles for the other bus masters once they have been granted the bus:
+ * the Ethernet controller, which also asserts DAS/ and ends its cycles on READY/, and cards on
+ * the expansion bus. */
+
+#ifndef BFM_H
+#define BFM_H
+
+#include <stdint.h>
+#include <functional>
+#include "Vtb_top.h"
+
+/* Half a period of the 40MHz oscillator, in ps */
+#define OSC_HALF_PS 12500
+
+/* Function codes */
+#define FC_USER_DATA 1
+#define FC_USER_PROGRAM 2
+#define FC_SUPER_DATA 5
+#define FC_SUPER_PROGRAM 6
+#define FC_CPU_SPACE 7
+
+enum class master {
+    cpu,
+    ethernet,
+    card0,                          /* Expansion bus request 0 */
+    card1                           /* Expansion bus request 1 */
+};
+
+/* How a cycle ended */
+enum class ending {
+    dtack,
+    vpa,
+    berr,
+    timeout                         /* Nothing ended it within bfm::TIMEOUT clocks */
+};
+
+struct transfer {
+    uint32_t addr;
+    uint8_t size;                   /* 1 or 2 bytes */
+    bool write;
+    uint8_t fc;
+};
+
+struct result {
+    ending end;
+    uint32_t clocks;                /* From S0 to the end of S7 */
+    uint32_t waits;                 /* Wait states, in clocks */
+};
+
+class bfm {
+public:
+    static constexpr uint32_t TIMEOUT = 1000;
+
+    /* Called after each evaluation of the model, twice for each period of the 40MHz clock, to
+     * run the device models and monitors */
+    std::function<void()> on_eval;
+
+    explicit bfm(Vtb_top *top);
+
+    /* Simulated time, in ps, and CPU clocks since the start */
+    uint64_t
+    now() const
+    {
+        return time_;
+    }
+
+    uint64_t
+    clocks() const
+    {
+        return clocks_;
+    }
+
+    /* Hold RESET/ for a number of clocks */
+    void reset(uint32_t clocks);
+
+    /* Let a number of clocks pass with no bus cycle */
+    void idle(uint32_t clocks);
+
+    /* Run one bus cycle as the given master, which must have been granted the bus */
+    result cycle(const transfer &a, master m = master::cpu);
+
+    /* Interrupt acknowledge cycle for a level */
+    result iack(uint8_t level);
+
+    /* Request the bus for a master, and grant it once the arbiter asks the CPU for the bus.
+     * Returns the number of clocks from request to grant, or TIMEOUT. */
+    uint32_t request(master m);
+
+    /* Give the bus back to the CPU */
+    void release(master m);
+
+private:
+    struct sample {
+        bool dtack;
+        bool berr;
+        bool vpa;
+        bool ready;
+        bool br;
+    };
+
+    Vtb_top *top_;
+    uint64_t time_;
+    uint64_t clocks_;
+    uint8_t e_phase_;               /* Clocks into the current E clock period */
+    sample pre_;                    /* Inputs just before the last edge */
+
+    void step();
+    void rise();
+    void fall();
+    bool granted(master m) const;
+    void set_request(master m, bool req);
+};
+
+#endif /* BFM_H */
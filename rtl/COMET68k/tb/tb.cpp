@@ -0,0 +1,614 @@
+/* Testbench for COMET68k_CPLD. See README.md.
+ *
+ *   ./comet68k-tb [-j] [-p profile] [-s seed] [-t ms]
+ *
+ * Boots the CPLD as the 68000 does, and then runs a random mix of every kind of bus cycle for the
+ * given time (20ms by default): ROM, DRAM, X-bus peripheral, Ethernet, expansion card and empty
+ * expansion bus accesses, interrupt acknowledges, and DMA by the Ethernet controller and by cards.
+ * The profile weights the mix like a kind of program: running from ROM, running from DRAM, or
+ * moving network traffic.
+ *
+ * Each cycle is checked to have ended the way it should (DTACK/, VPA/ or BERR/), and the number
+ * of wait states is recorded for each type of access. Monitors check, throughout, that DTACK/ is
+ * negated before each cycle starts, that BERR/ is only asserted while the CPU owns the bus, and
+ * that DRAM refresh is CAS/ before RAS/ with WE/ (R/W) high and frequent enough for the
+ * TC5118180 (1024 rows every 16ms). DRAM accesses which take longer than the fastest are counted, as they were held up by
+ * a refresh. So are the accesses which a refresh overlapped: for DRAM, those which collided with
+ * it, and for anything else, those which hid it.
+ *
+ * A table, or with -j one JSON object per line, is written at the end. The exit status is 1 if
+ * any check failed. */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <verilated.h>
+#include "Vtb_top.h"
+#include "bfm.h"
+
+#define PS_PER_MS 1000000000ULL
+#define PS_PER_US 1000000ULL
+
+/* TC5118180: 1024 refresh cycles every 16ms */
+#define REFRESH_ROWS 1024
+#define REFRESH_PERIOD_PS (16 * PS_PER_MS)
+
+/* Bus watchdog: BERR/ after 2^BITS clocks of AS/, less the clocks of S2-S4 */
+#define WATCHDOG_BITS 5
+#define BERR_WAITS ((1 << WATCHDOG_BITS) - 2)
+
+/* Device models, in periods of the 40MHz clock from the start of their cycle to their DTACK/
+ * or READY/ */
+#define CARD_DELAY 4                /* A card on the expansion bus */
+#define LANCE_DELAY 6               /* Am7990 as a slave */
+#define CARD_BASE 0x400000          /* Window of the card, see libcomet/cards.h */
+#define CARD_SIZE 0x1000
+#define VECTOR_LEVEL 3              /* Level at which a card supplies its own vector */
+#define DRAM_SIZE 0x400000
+
+/* Periods of the 40MHz clock from RAS/ of a refresh until the DRAM machine can start an access,
+ * from the parameters of dram_machine: RAS/ for REFRESH_WAIT_STATES + 1, and precharge for
+ * PRECHARGE_WAIT_STATES + 1 */
+#define REFRESH_BUSY 7
+
+/* Print no more than this many failures */
+#define MAX_FAILURES 20
+
+struct stats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t slow;                  /* Taking longer than the fastest */
+    uint64_t extra;                 /* Wait states more than the fastest */
+    uint32_t refreshes;             /* Overlapped by a refresh */
+    bool dram;
+    std::vector<uint32_t> waits;
+};
+
+static std::unique_ptr<VerilatedContext> context;
+static Vtb_top *top;
+static bfm *bus;
+
+static std::map<std::string, stats> results;
+static std::vector<uint64_t> refreshes;
+static uint32_t failures;
+static bool json;
+static bool booted;
+
+/* The state of the board as of the last evaluation, for the monitors */
+static struct {
+    bool as;
+    bool ras0;
+    bool ras1;
+    uint32_t card_clocks;
+    uint32_t lance_clocks;
+    uint64_t as_asserted;           /* When AS/ was last asserted, in ps */
+} last = { true, true, true, 0, 0, 0 };
+
+static const char *const ending_names[] = { "DTACK/", "VPA/", "BERR/", "timeout" };
+
+static void
+fail(const char *fmt, ...)
+{
+    va_list args;
+
+    failures++;
+
+    if (failures <= MAX_FAILURES) {
+        fprintf(stderr, "%10.3fus: ", (double)bus->now() / PS_PER_US);
+        va_start(args, fmt);
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+        fputc('\n', stderr);
+    }
+}
+
+/* An expansion card at CARD_BASE and a card which supplies its own vector, both answering
+ * DTACK/ after CARD_DELAY, and the Ethernet controller answering READY/ after LANCE_DELAY */
+static void
+devices(void)
+{
+    uint32_t addr = top->addr << 1;
+    bool strobe = !top->n_uds || !top->n_lds;
+    bool card = !top->n_as && strobe && top->fc != FC_CPU_SPACE &&
+        addr >= CARD_BASE && addr < CARD_BASE + CARD_SIZE;
+    bool vector = !top->n_as && !top->n_iack_out &&
+        ((addr >> 1) & 7) == VECTOR_LEVEL;
+
+    last.card_clocks = (card || vector) ? last.card_clocks + 1 : 0;
+    top->n_ext_dtack = !(last.card_clocks > CARD_DELAY * 2);
+
+    /* DAS/ from the CPLD, rather than from the Ethernet controller itself */
+    if (!top->n_eth_das && !top->eth_das) {
+        last.lance_clocks++;
+    } else {
+        last.lance_clocks = 0;
+    }
+
+    top->eth_ready = last.lance_clocks > LANCE_DELAY * 2;
+}
+
+static void
+monitors(void)
+{
+    bool as = top->n_as;
+    bool ras0 = top->n_ras0;
+    bool ras1 = top->n_ras1;
+    bool cas = !top->n_ucas && !top->n_lcas;
+    bool cpu = top->n_eth_bg && top->n_bg0 && top->n_bg1;
+
+    if (last.as && !as) {
+        last.as_asserted = bus->now();
+
+        if (!top->n_dtack) {
+            fail("DTACK/ asserted at the start of a cycle");
+        }
+    }
+
+    if (!top->n_berr && !cpu) {
+        fail("BERR/ asserted while the CPU does not own the bus");
+    }
+
+    /* A refresh asserts both RAS/ together, after both CAS/, and with WE/ high, as WE/ low would
+     * make it a WCBR cycle and put the DRAM into its test mode. WE/ is R/W. */
+    if ((last.ras0 && !ras0) || (last.ras1 && !ras1)) {
+        if (cas) {
+            if (!last.ras0 || !last.ras1 || ras0 || ras1) {
+                fail("CAS/ before RAS/ refresh not on both banks at once");
+            }
+
+            if (!top->n_write) {
+                fail("WE/ low at RAS/ of a refresh (WCBR)");
+            }
+
+            refreshes.push_back(bus->now());
+        } else if (!top->n_ucas || !top->n_lcas) {
+            fail("CAS/ asserted before RAS/ in an access");
+        }
+    }
+
+    last.as = as;
+    last.ras0 = ras0;
+    last.ras1 = ras1;
+}
+
+static void
+on_eval(void)
+{
+    devices();
+    monitors();
+}
+
+/* Whether a refresh was in progress at any time from AS/ being asserted until now, the end of
+ * the cycle */
+static bool
+refreshed(void)
+{
+    uint64_t from = last.as_asserted - REFRESH_BUSY * 2 * OSC_HALF_PS;
+
+    return !refreshes.empty() && refreshes.back() > from;
+}
+
+static void
+record(const char *type, const result &r, ending expect, bool dram = false)
+{
+    stats &s = results[type];
+
+    s.dram = dram;
+
+    if (refreshed()) {
+        s.refreshes++;
+    }
+
+    if (r.end != expect) {
+        fail("%s: ended with %s, not %s", type, ending_names[(int)r.end],
+             ending_names[(int)expect]);
+        return;
+    }
+
+    if (expect == ending::berr && (r.waits < BERR_WAITS - 2 || r.waits > BERR_WAITS + 2)) {
+        fail("%s: bus error after %u wait states", type, r.waits);
+    }
+
+    s.waits.push_back(r.waits);
+}
+
+static void
+run(const char *type, uint32_t addr, uint8_t size, bool write, ending expect = ending::dtack,
+    master m = master::cpu)
+{
+    transfer a = { addr, size, write, (uint8_t)(m == master::cpu ? FC_SUPER_DATA : FC_USER_DATA) };
+
+    record(type, bus->cycle(a, m), expect, booted && addr < DRAM_SIZE);
+}
+
+/* Raise an interrupt, check that the CPU sees its level, and acknowledge it */
+static void
+interrupt(const char *type, uint8_t level, CData *line, bool active_low, ending expect)
+{
+    *line = active_low ? 0 : 1;
+    bus->idle(2);
+
+    if ((uint8_t)(~top->n_ipl & 7) != level) {
+        fail("%s: IPL %u, not %u", type, ~top->n_ipl & 7, level);
+    }
+
+    record(type, bus->iack(level), expect);
+    *line = active_low ? 1 : 0;
+    bus->idle(2);
+}
+
+static void
+dma(const char *type, master m, uint32_t addr, int cycles)
+{
+    uint32_t clocks = bus->request(m);
+
+    if (clocks == bfm::TIMEOUT) {
+        fail("%s: bus not granted", type);
+        return;
+    }
+
+    results[std::string(type) + " grant"].waits.push_back(clocks);
+
+    for (; cycles > 0; cycles--) {
+        run(type, addr, 2, cycles & 1, ending::dtack, m);
+        addr = (addr + 2) & 0x3FFFFE;
+    }
+
+    bus->release(m);
+}
+
+/* 32 bit LCG, as in Numerical Recipes */
+static uint32_t seed = 1;
+
+static uint32_t
+rnd(uint32_t range)
+{
+    seed = seed * 1664525 + 1013904223;
+
+    return (seed >> 8) % range;
+}
+
+static void
+boot(void)
+{
+    uint32_t addr;
+
+    bus->reset(8);
+
+    /* Reset vectors from ROM1 at 0, then the first access to ROM1 at its own address moves ROM
+     * out of the way of DRAM */
+    for (addr = 0; addr < 8; addr += 2) {
+        run("rom (at reset)", addr, 2, false);
+    }
+
+    run("rom1 read", 0xF80400, 2, false);
+    booted = true;
+}
+
+/* Kinds of bus cycle in the mix */
+enum op {
+    OP_ROM1,
+    OP_ROM0,
+    OP_DRAM_READ,
+    OP_DRAM_WRITE,
+    OP_DRAM_WRITE_BYTE,
+    OP_UART_READ,
+    OP_UART_WRITE,
+    OP_TIMER,
+    OP_IO,
+    OP_ETHERNET,
+    OP_CARD,
+    OP_EXPANSION,
+    OP_IACK_TIMER,
+    OP_IACK_UART,
+    OP_IACK_VECTORED,
+    OP_IACK_SPURIOUS,
+    OP_ETHERNET_DMA,
+    OP_CARD0_DMA,
+    OP_CARD1_DMA,
+    OP_NONE,                        /* Only internal operations */
+    OPS
+};
+
+/* Weights of each kind of cycle, in the order of enum op */
+struct profile {
+    const char *name;
+    uint16_t weights[OPS];
+};
+
+static const profile profiles[] = {
+    /* Every kind of cycle, for checking */
+    { "mix", { 300, 50, 250, 100, 50, 30, 20, 20, 10, 30, 20, 5, 5, 5, 5, 2, 10, 5, 3, 80 } },
+
+    /* The bootloader or monitor: instructions from ROM, stack and data in DRAM */
+    { "rom", { 550, 20, 180, 100, 30, 30, 30, 10, 5, 5, 0, 0, 5, 5, 0, 0, 0, 0, 0, 30 } },
+
+    /* A program loaded into DRAM: instructions and data in DRAM, with a little I/O */
+    { "dram", { 5, 0, 620, 180, 40, 10, 10, 5, 5, 10, 10, 0, 5, 5, 0, 0, 5, 0, 0, 90 } },
+
+    /* A network stack: a program in DRAM, with the Ethernet controller busy moving packets */
+    { "net", { 5, 0, 500, 150, 30, 5, 5, 5, 0, 60, 0, 0, 5, 0, 0, 0, 150, 0, 0, 85 } },
+};
+
+static const profile *mix_profile = &profiles[0];
+
+static void
+mix(void)
+{
+    uint32_t dram = rnd(DRAM_SIZE) & ~1u;
+    uint32_t total = 0;
+    uint32_t pick;
+    int op;
+
+    for (op = 0; op < OPS; op++) {
+        total += mix_profile->weights[op];
+    }
+
+    pick = rnd(total);
+
+    for (op = 0; pick >= mix_profile->weights[op]; op++) {
+        pick -= mix_profile->weights[op];
+    }
+
+    switch (op) {
+        case OP_ROM1:
+            run("rom1 read", 0xF80000 + (rnd(0x80000) & ~1u), 2, false);
+            break;
+
+        case OP_ROM0:
+            run("rom0 read", 0xF00000 + (rnd(0x80000) & ~1u), 2, false);
+            break;
+
+        case OP_DRAM_READ:
+            run("dram read", dram, 2, false);
+            break;
+
+        case OP_DRAM_WRITE:
+            run("dram write", dram, 2, true);
+            break;
+
+        case OP_DRAM_WRITE_BYTE:
+            run("dram write", dram + rnd(2), 1, true);
+            break;
+
+        case OP_UART_READ:
+            run("uart read", 0xC20008 + rnd(8), 1, false);
+            break;
+
+        case OP_UART_WRITE:
+            run("uart write", 0xC20008 + rnd(8), 1, true);
+            break;
+
+        case OP_TIMER:
+            run("timer read", 0xC30000 + rnd(0x20), 1, false);
+            break;
+
+        case OP_IO:
+            run("io read", 0xC10000 + rnd(2), 1, false);
+            break;
+
+        case OP_ETHERNET:
+            run("ethernet", 0xC40000 + (rnd(4) & ~1u), 2, rnd(2));
+            break;
+
+        case OP_CARD:
+            run("card", CARD_BASE + (rnd(CARD_SIZE) & ~1u), 2, rnd(2));
+            break;
+
+        case OP_EXPANSION:
+            run("expansion (empty)", 0x800000 + (rnd(0x10000) & ~1u), 2, false, ending::berr);
+            break;
+
+        case OP_IACK_TIMER:
+            interrupt("iack timer", 1, &top->n_timer_irq, true, ending::vpa);
+            break;
+
+        case OP_IACK_UART:
+            interrupt("iack uart", 5, &top->uart_irq, false, ending::vpa);
+            break;
+
+        case OP_IACK_VECTORED:
+            interrupt("iack vectored", VECTOR_LEVEL, &top->n_irq3, true, ending::dtack);
+            break;
+
+        case OP_IACK_SPURIOUS:
+            interrupt("iack spurious", 2, &top->n_irq2, true, ending::berr);
+            break;
+
+        case OP_ETHERNET_DMA:
+            dma("ethernet dma", master::ethernet, dram, 4);
+            break;
+
+        case OP_CARD0_DMA:
+            dma("card0 dma", master::card0, dram, 2);
+            break;
+
+        case OP_CARD1_DMA:
+            dma("card1 dma", master::card1, dram, 2);
+            break;
+
+        default:
+            break;
+    }
+
+    /* Internal operations of the CPU between cycles */
+    bus->idle(rnd(4));
+}
+
+static void
+summarise(stats &s)
+{
+    s.count = s.waits.size();
+    s.min = UINT32_MAX;
+    s.max = 0;
+    s.total = 0;
+
+    for (uint32_t w : s.waits) {
+        s.min = w < s.min ? w : s.min;
+        s.max = w > s.max ? w : s.max;
+        s.total += w;
+    }
+
+    s.slow = 0;
+    s.extra = 0;
+
+    for (uint32_t w : s.waits) {
+        if (w > s.min) {
+            s.slow++;
+            s.extra += w - s.min;
+        }
+    }
+}
+
+static void
+report(void)
+{
+    uint64_t worst = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    uint32_t collided = 0;
+    uint32_t hidden = 0;
+    size_t ctr;
+
+    if (!json) {
+        printf("%-22s %7s %5s %7s %5s %7s %7s\n", "access", "count", "min", "avg", "max", "slow",
+               "refresh");
+    }
+
+    for (auto &r : results) {
+        stats &s = r.second;
+
+        summarise(s);
+
+        if (s.count == 0) {
+            continue;
+        }
+
+        if (s.dram) {
+            collided += s.refreshes;
+        } else {
+            hidden += s.refreshes;
+        }
+
+        if (json) {
+            printf("{\"access\": \"%s\", \"count\": %u, \"min\": %u, \"avg\": %.2f, "
+                   "\"max\": %u, \"slow\": %u, \"extra\": %llu, \"refresh\": %u, "
+                   "\"dram\": %s}\n",
+                   r.first.c_str(), s.count, s.min, (double)s.total / s.count, s.max, s.slow,
+                   (unsigned long long)s.extra, s.refreshes, s.dram ? "true" : "false");
+        } else {
+            printf("%-22s %7u %5u %7.2f %5u %7u %7u\n", r.first.c_str(), s.count, s.min,
+                   (double)s.total / s.count, s.max, s.slow, s.refreshes);
+        }
+    }
+
+    for (ctr = 1; ctr < refreshes.size(); ctr++) {
+        uint64_t gap = refreshes[ctr] - refreshes[ctr - 1];
+
+        min = gap < min ? gap : min;
+        max = gap > max ? gap : max;
+    }
+
+    /* The longest it took to refresh every row */
+    for (ctr = REFRESH_ROWS; ctr < refreshes.size(); ctr++) {
+        uint64_t span = refreshes[ctr] - refreshes[ctr - REFRESH_ROWS];
+
+        worst = span > worst ? span : worst;
+    }
+
+    if (refreshes.size() <= REFRESH_ROWS) {
+        fail("refresh: only %zu refreshes, run for longer", refreshes.size());
+    } else if (worst > REFRESH_PERIOD_PS) {
+        fail("refresh: %.4fms to refresh every row", (double)worst / PS_PER_MS);
+    }
+
+    if (refreshes.size() > 1) {
+        if (json) {
+            printf("{\"profile\": \"%s\", \"refresh\": %zu, \"hidden\": %u, \"collided\": %u, "
+                   "\"min_us\": %.3f, \"max_us\": %.3f, \"rows_ms\": %.4f}\n",
+                   mix_profile->name, refreshes.size(), hidden, collided,
+                   (double)min / PS_PER_US, (double)max / PS_PER_US, (double)worst / PS_PER_MS);
+        } else {
+            printf("\n%zu refreshes, %.3f-%.3fus apart, every row in %.4fms (limit 16ms)\n",
+                   refreshes.size(), (double)min / PS_PER_US, (double)max / PS_PER_US,
+                   (double)worst / PS_PER_MS);
+            printf("%u hidden by other cycles, %u DRAM accesses collided with one (%s profile)\n",
+                   hidden, collided, mix_profile->name);
+        }
+    }
+
+    if (!json) {
+        printf("%u check%s failed\n", failures, failures == 1 ? "" : "s");
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t duration = 20 * PS_PER_MS;
+    int opt;
+    size_t ctr;
+
+    while ((opt = getopt(argc, argv, "jp:s:t:")) != -1) {
+        switch (opt) {
+            case 'j':
+                json = true;
+                break;
+
+            case 'p':
+                mix_profile = nullptr;
+
+                for (ctr = 0; ctr < sizeof(profiles) / sizeof(profiles[0]); ctr++) {
+                    if (std::string(optarg) == profiles[ctr].name) {
+                        mix_profile = &profiles[ctr];
+                    }
+                }
+
+                if (mix_profile == nullptr) {
+                    fprintf(stderr, "Unknown profile %s: mix, rom, dram or net\n", optarg);
+                    return 1;
+                }
+
+                break;
+
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+
+            case 't':
+                duration = strtoull(optarg, NULL, 0) * PS_PER_MS;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-j] [-p profile] [-s seed] [-t ms]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    context.reset(new VerilatedContext);
+    top = new Vtb_top(context.get());
+    bus = new bfm(top);
+    bus->on_eval = on_eval;
+
+    boot();
+
+    while (bus->now() < duration) {
+        mix();
+    }
+
+    report();
+
+    top->final();
+    delete bus;
+    delete top;
+
+    return failures ? 1 : 0;
+}
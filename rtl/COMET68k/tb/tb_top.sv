@@ -0,0 +1,164 @@
+`timescale 1ns/1ns
+
+/* Testbench top for COMET68k_CPLD
+ *
+ * Stands in for the rest of the board around the CPLD: the wired-OR DTACK/ of the system bus,
+ * and the pull-ups on the DAS/ and READY/ signals shared with the Ethernet controller. The
+ * address bus is presented whole, and split into the bits which reach the CPLD.
+ *
+ * Everything driven here is driven, and everything output is checked, by the 68000 bus
+ * functional model and device models in tb.cpp. See README.md. */
+module tb_top(
+    input osc_40mhz,
+    input n_reset,
+    output cpu_clk,
+    output timer_clk,
+
+    /* Bus master */
+    input [23:1] addr,
+    input n_as,
+    input n_uds,
+    input n_lds,
+    input n_write,
+    input [2:0] fc,
+    output n_dtack,
+    output n_berr,
+
+    /* DTACK/ from devices other than the CPLD: expansion cards and vectored interruptors */
+    input n_ext_dtack,
+
+    /* DRAM */
+    output n_ras0,
+    output n_ras1,
+    output n_ucas,
+    output n_lcas,
+    output masel,
+
+    /* X-bus */
+    output xa0,
+    output n_rom0_cs,
+    output n_rom1_cs,
+    output n_io_cs,
+    output n_uart_cs,
+    output n_timer_cs,
+
+    /* Ethernet controller. eth_das and eth_ready pull DAS/ and READY/ low. */
+    output n_eth_cs,
+    input eth_das,
+    input eth_ready,
+    output n_eth_das,
+    output n_eth_ready,
+
+    /* Interrupts */
+    input nmi,
+    input n_irq7,
+    input n_irq6,
+    input uart_irq,
+    input n_irq5,
+    input n_eth_irq,
+    input n_irq4,
+    input n_irq3,
+    input n_irq2,
+    input n_irq1,
+    input n_timer_irq,
+    input soft_irq,
+    input n_autovec,
+    output [2:0] n_ipl,
+    output n_vpa,
+    output n_iack_out,
+
+    /* Bus arbitration */
+    output n_br,
+    input n_bg,
+    input n_eth_br,
+    output n_eth_bg,
+    input n_br0,
+    output n_bg0,
+    input n_br1,
+    output n_bg1
+);
+    wire n_dtack_drv;
+    wire n_berr_drv;
+
+    /* Open collector on the board */
+    assign n_dtack = n_dtack_drv && n_ext_dtack;
+    assign n_berr = n_berr_drv;
+
+    /* Driven by the CPLD in slave cycles (DAS/) and master cycles (READY/), and otherwise by the
+     * Ethernet controller */
+    tri1 das_net;
+    tri1 ready_net;
+
+    assign das_net = eth_das ? 1'b0 : 1'bZ;
+    assign ready_net = eth_ready ? 1'b0 : 1'bZ;
+    assign n_eth_das = das_net;
+    assign n_eth_ready = ready_net;
+
+    COMET68k_CPLD cpld(
+        .osc_40mhz(osc_40mhz),
+        .eth_clk(),
+        .cpu_clk(cpu_clk),
+        .timer_clk(timer_clk),
+        .n_reset(n_reset),
+        .debug1(),
+        .debug2(),
+        .cpld_func1(1'b1),
+        .addr(addr[23:16]),
+        .a1(addr[1]),
+        .a2(addr[2]),
+        .a3(addr[3]),
+        .n_as(n_as),
+        .n_uds(n_uds),
+        .n_lds(n_lds),
+        .n_write(n_write),
+        .n_dtack(n_dtack),
+        .fc(fc),
+        .n_berr_drv(n_berr_drv),
+        .n_ras0(n_ras0),
+        .n_ras1(n_ras1),
+        .n_ucas(n_ucas),
+        .n_lcas(n_lcas),
+        .masel(masel),
+        .xa0(xa0),
+        .n_xd_lreg_le(),
+        .n_xd_lreg_oe(),
+        .n_xd_ubuf_oe(),
+        .n_xd_lbuf_oe(),
+        .n_rom0_cs(n_rom0_cs),
+        .n_rom1_cs(n_rom1_cs),
+        .n_io_cs(n_io_cs),
+        .n_uart_cs(n_uart_cs),
+        .n_timer_cs(n_timer_cs),
+        .own(),
+        .ddir(),
+        .n_dben(),
+        .n_dtack_drv(n_dtack_drv),
+        .n_eth_cs(n_eth_cs),
+        .n_eth_das(das_net),
+        .n_eth_ready(ready_net),
+        .nmi(nmi),
+        .n_irq7(n_irq7),
+        .n_irq6(n_irq6),
+        .uart_irq(uart_irq),
+        .n_irq5(n_irq5),
+        .n_eth_irq(n_eth_irq),
+        .n_irq4(n_irq4),
+        .n_irq3(n_irq3),
+        .n_irq2(n_irq2),
+        .n_irq1(n_irq1),
+        .n_timer_irq(n_timer_irq),
+        .soft_irq(soft_irq),
+        .n_autovec(n_autovec),
+        .n_ipl(n_ipl),
+        .n_vpa(n_vpa),
+        .n_iack_out(n_iack_out),
+        .n_br(n_br),
+        .n_bg(n_bg),
+        .n_eth_br(n_eth_br),
+        .n_eth_bg(n_eth_bg),
+        .n_br0(n_br0),
+        .n_bg0(n_bg0),
+        .n_br1(n_br1),
+        .n_bg1(n_bg1)
+    );
+endmodule /* tb_top */
@@ -0,0 +1,64 @@
+#ifndef DP8570A_H
+#define DP8570A_H
+
+#include "COMET68k.h"               /* Generated from COMET68k.dts */
+
+#define TIMER_BASE DT_TIMER0_REG_ADDR   /* Base address of the DP8570A */
+
+#define TIMER_CLOCK DT_TIMER0_CLOCK_FREQUENCY
+                                    /* TCK, from the CPLD (40MHz / 64) */
+
+/* Registers of page 0. Those from 0x01 to 0x04 are in one of two blocks,
+ * selected by RS in the Main Status Register. */
+#define TIMER_MSR_REG (0)           /* Main Status Register (r/w) */
+#define TIMER_T0CR_REG (0x1)        /* Timer 0 Control Register (RS=0) */
+#define TIMER_T1CR_REG (0x2)        /* Timer 1 Control Register (RS=0) */
+#define TIMER_PFR_REG (0x3)         /* Periodic Flag Register (RS=0) */
+#define TIMER_IRR_REG (0x4)         /* Interrupt Routing Register (RS=0) */
+#define TIMER_RTMR_REG (0x1)        /* Real Time Mode Register (RS=1) */
+#define TIMER_OMR_REG (0x2)         /* Output Mode Register (RS=1) */
+#define TIMER_ICR0_REG (0x3)        /* Interrupt Control Register 0 (RS=1) */
+#define TIMER_ICR1_REG (0x4)        /* Interrupt Control Register 1 (RS=1) */
+#define TIMER_T0LSB_REG (0xF)       /* Timer 0 data, or count once latched */
+#define TIMER_T0MSB_REG (0x10)
+#define TIMER_T1LSB_REG (0x11)      /* Timer 1 data, or count once latched */
+#define TIMER_T1MSB_REG (0x12)
+
+/* Main Status Register. The interrupt flags are cleared by writing 1. */
+#define TIMER_MSR_PS 0x80           /* Page select */
+#define TIMER_MSR_RS 0x40           /* Register block select */
+#define TIMER_MSR_T1 0x20           /* Timer 1 has reached zero */
+#define TIMER_MSR_T0 0x10           /* Timer 0 has reached zero */
+
+/* Timer Control Registers */
+#define TIMER_TCR_CHG 0x80          /* Count hold/gate */
+#define TIMER_TCR_RD 0x40           /* Latch the count, until the LSB is read */
+#define TIMER_TCR_CLK_EXT 0x00      /* Input clock select: TCK */
+#define TIMER_TCR_CLK_XTAL 0x08     /* Crystal */
+#define TIMER_TCR_CLK_1KHZ 0x20     /* 1ms */
+#define TIMER_TCR_MODE0 0x00        /* Single pulse */
+#define TIMER_TCR_MODE1 0x02        /* Rate generator, reloads at zero */
+#define TIMER_TCR_MODE2 0x04        /* Square wave */
+#define TIMER_TCR_MODE3 0x06        /* Retriggerable one shot */
+#define TIMER_TCR_TSS 0x01          /* Start (1) or stop and reset (0) */
+
+/* Interrupt Control Register 0 */
+#define TIMER_ICR0_T1 0x80          /* Timer 1 interrupt enable */
+#define TIMER_ICR0_T0 0x40          /* Timer 0 interrupt enable */
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#define TMSR (*(volatile uint8_t *)(TIMER_BASE + TIMER_MSR_REG))
+#define TT0CR (*(volatile uint8_t *)(TIMER_BASE + TIMER_T0CR_REG))
+#define TT1CR (*(volatile uint8_t *)(TIMER_BASE + TIMER_T1CR_REG))
+#define TICR0 (*(volatile uint8_t *)(TIMER_BASE + TIMER_ICR0_REG))
+#define TT0LSB (*(volatile uint8_t *)(TIMER_BASE + TIMER_T0LSB_REG))
+#define TT0MSB (*(volatile uint8_t *)(TIMER_BASE + TIMER_T0MSB_REG))
+#define TT1LSB (*(volatile uint8_t *)(TIMER_BASE + TIMER_T1LSB_REG))
+#define TT1MSB (*(volatile uint8_t *)(TIMER_BASE + TIMER_T1MSB_REG))
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* DP8570A_H */
@@ -1,9 +1,12 @@
 #ifndef TL16C2552_H
 #define TL16C2552_H
 
-#define UART_BASE 0x00C20000        /* Base address of the UART */
+#include "COMET68k.h"               /* Generated from COMET68k.dts */
 
-#define UART_CHA 0x8                /* A3 high to access ch A regs.
+#define UART_BASE DT_SERIAL1_REG_ADDR   /* Base address of the UART */
+
+#define UART_CHA (DT_SERIAL0_REG_ADDR - UART_BASE)
+                                    /* A3 high to access ch A regs.
                                      * Ch B is accessed with A3 low. */
 
 #define UART_RBR_REG (0)            /* Receiver Buffer Register (r) */
@@ -0,0 +1,140 @@
+/* Generated by structbits.py from TL16C2552.h, do not edit. To regenerate:
+ *
+ *   python3 structbits.py TL16C2552.h -c TL16C2552.hpp
+ *
+ * Each register is a type, with a constexpr descriptor for each of its
+ * fields, named as in the bitfield unions but in lower case. Calling a
+ * descriptor gives the field's value in position, and values for fields of
+ * the same register are combined with | and written in one store:
+ *
+ *   using namespace tl16c2552;
+ *   ualcr::write(ualcr::dlab(1) | ualcr::wlen(3));
+ *
+ * rather than a read, modify and write for each field as with the unions.
+ * modify() keeps the fields that are not given. */
+
+#ifndef TL16C2552_HPP
+#define TL16C2552_HPP
+
+#include <stdint.h>
+#include "TL16C2552.h"
+#include "mmio.hpp"
+
+namespace tl16c2552 {
+
+template <uintptr_t Addr>
+struct uartier : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> mstat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> lstat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> txempty{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> rxdat{};
+};
+
+template <uintptr_t Addr>
+struct uartiir : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 7, 1> fifoen1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 1> fifoen0{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 2> fifoen{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> ipend3{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> ipend2{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> ipend1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> ipend0{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 4> ipend{};
+};
+
+template <uintptr_t Addr>
+struct uartfcr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 7, 1> rxtrg1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 1> rxtrg0{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 2> rxtrg{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> dmasel{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> txrst{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> rxrst{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> en{};
+};
+
+template <uintptr_t Addr>
+struct uartlcr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 7, 1> dlab{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 1> txbrk{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 5, 1> pforce{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 4, 1> peven{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> pen{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> slen{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> wlen1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> wlen0{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 2> wlen{};
+};
+
+template <uintptr_t Addr>
+struct uartmcr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 5, 1> autoflow{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 4, 1> loop{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> op2{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> op1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> rtsoc{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> dtroc{};
+};
+
+template <uintptr_t Addr>
+struct uartlsr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 7, 1> rxerr{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 1> txidl{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 5, 1> thre{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 4, 1> rxbrk{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> ferr{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> perr{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> oerr{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> rxd{};
+};
+
+template <uintptr_t Addr>
+struct uartmsr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 7, 1> cdstat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 6, 1> ristat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 5, 1> dsrstat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 4, 1> ctsstat{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 3, 1> cdchg{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> richg{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> dsrchg{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> ctschg{};
+};
+
+template <uintptr_t Addr>
+struct uartafr : mmio::reg<Addr, uint8_t> {
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 2, 1> mfsel1{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 1> mfsel0{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 1, 2> mfsel{};
+    static constexpr mmio::field<mmio::reg<Addr, uint8_t>, 0, 1> both{};
+};
+
+using uarbr = mmio::reg<(UART_BASE + UART_CHA + UART_RBR_REG), uint8_t>;
+using uathr = mmio::reg<(UART_BASE + UART_CHA + UART_THR_REG), uint8_t>;
+using uaier = uartier<(UART_BASE + UART_CHA + UART_IER_REG)>;
+using uaiir = uartiir<(UART_BASE + UART_CHA + UART_IIR_REG)>;
+using uafcr = uartfcr<(UART_BASE + UART_CHA + UART_FCR_REG)>;
+using ualcr = uartlcr<(UART_BASE + UART_CHA + UART_LCR_REG)>;
+using uamcr = uartmcr<(UART_BASE + UART_CHA + UART_MCR_REG)>;
+using ualsr = uartlsr<(UART_BASE + UART_CHA + UART_LSR_REG)>;
+using uamsr = uartmsr<(UART_BASE + UART_CHA + UART_MSR_REG)>;
+using uascr = mmio::reg<(UART_BASE + UART_CHA + UART_SCR_REG), uint8_t>;
+using uadll = mmio::reg<(UART_BASE + UART_CHA + UART_DLL_REG), uint8_t>;
+using uadlm = mmio::reg<(UART_BASE + UART_CHA + UART_DLM_REG), uint8_t>;
+using uaafr = uartafr<(UART_BASE + UART_CHA + UART_AFR_REG)>;
+using ubrbr = mmio::reg<(UART_BASE + UART_RBR_REG), uint8_t>;
+using ubthr = mmio::reg<(UART_BASE + UART_THR_REG), uint8_t>;
+using ubier = uartier<(UART_BASE + UART_IER_REG)>;
+using ubiir = uartiir<(UART_BASE + UART_IIR_REG)>;
+using ubfcr = uartfcr<(UART_BASE + UART_FCR_REG)>;
+using ublcr = uartlcr<(UART_BASE + UART_LCR_REG)>;
+using ubmcr = uartmcr<(UART_BASE + UART_MCR_REG)>;
+using ublsr = uartlsr<(UART_BASE + UART_LSR_REG)>;
+using ubmsr = uartmsr<(UART_BASE + UART_MSR_REG)>;
+using ubscr = mmio::reg<(UART_BASE + UART_SCR_REG), uint8_t>;
+using ubdll = mmio::reg<(UART_BASE + UART_DLL_REG), uint8_t>;
+using ubdlm = mmio::reg<(UART_BASE + UART_DLM_REG), uint8_t>;
+using ubafr = uartafr<(UART_BASE + UART_AFR_REG)>;
+
+}
+
+#endif /* TL16C2552_HPP */
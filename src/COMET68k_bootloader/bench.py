@@ -0,0 +1,316 @@
+# Benchmark the serial bootloader protocol
+#
+# Each command is run across a sweep of payload sizes and data types, and the
+# time taken is recorded. From these, the effective throughput of each transfer
+# is calculated along with how close it comes to the rate the line can carry.
+# A straight line fitted through the results of each command and data type
+# gives its fixed per-command overhead, and its asymptotic throughput.
+#
+# All data written is read back and compared, so the benchmark doubles as a
+# test of the protocol.
+#
+# Results are written as JSON. Given a previous set of results with --baseline,
+# any command whose throughput has dropped by more than the tolerance is
+# reported, and the script exits with a non-zero status.
+#
+# The target may be the real hardware, or the simulator in sim/ (use its -d
+# option so that character times are modelled).
+
+import argparse
+import json
+import random
+import sys
+import time
+
+from bootproto import BootloaderLink, BootloaderError
+from loader4 import DEV, BAUD, convert_arg_to_long
+
+DEFAULT_SIZES = '0,4,16,64,256,1024,4096'
+DEFAULT_ADDR = '0x10000'
+DEFAULT_REPEAT = 3
+DEFAULT_TOLERANCE = 5.0
+
+COMMANDS = ['LOAD_CODE', 'WRITE_MEM', 'READ_MEM', 'READ_BLOCK']
+TYPE_NAMES = {1: 'byte', 2: 'word', 4: 'long'}
+
+
+def run_one(link: BootloaderLink, command: str, width: int, addr: int,
+            size: int) -> float:
+    """ Run a single command moving size bytes, check the result, and return
+    the time taken in seconds """
+    data = random.randbytes(size)
+    count = size // width
+
+    if command == 'LOAD_CODE':
+        start = time.perf_counter()
+        link.load_code(addr, data)
+        duration = time.perf_counter() - start
+
+        check = link.read_mem(addr, size)
+    elif command == 'WRITE_MEM':
+        start = time.perf_counter()
+        link.write_mem(addr, data, width)
+        duration = time.perf_counter() - start
+
+        check = link.read_mem(addr, size)
+    elif command == 'READ_MEM':
+        link.load_code(addr, data)
+
+        start = time.perf_counter()
+        check = link.read_mem(addr, count, width)
+        duration = time.perf_counter() - start
+    elif command == 'READ_BLOCK':
+        link.load_code(addr, data[:width])
+
+        start = time.perf_counter()
+        check = link.read_mem(addr, count, width, block=True)
+        duration = time.perf_counter() - start
+
+        # Every item read should be a copy of the first
+        data = data[:width] * count
+
+    if check != data:
+        raise BootloaderError(
+            f'{command} {TYPE_NAMES[width]} x {count}: data mismatch'
+        )
+
+    return duration
+
+
+def fit(points: list) -> tuple:
+    """ Least squares fit of time = overhead + bytes / rate. Returns the
+    overhead in seconds and the rate in bytes per second. """
+    n = len(points)
+
+    if n < 2:
+        return (None, None)
+
+    sx = sum(p[0] for p in points)
+    sy = sum(p[1] for p in points)
+    sxx = sum(p[0] * p[0] for p in points)
+    sxy = sum(p[0] * p[1] for p in points)
+    denom = n * sxx - sx * sx
+
+    if denom == 0:
+        return (None, None)
+
+    slope = (n * sxy - sx * sy) / denom
+    intercept = (sy - slope * sx) / n
+
+    return (intercept, (1 / slope) if slope > 0 else None)
+
+
+def compare(results: dict, baseline: dict, tolerance: float) -> list:
+    """ Return a list of descriptions of results which have regressed from
+    the baseline by more than tolerance percent """
+    regressions = []
+    old = {
+        (r['command'], r['width'], r['bytes']): r
+        for r in baseline.get('results', [])
+    }
+
+    for r in results['results']:
+        prev = old.get((r['command'], r['width'], r['bytes']))
+
+        if prev is None:
+            continue
+
+        # Zero length transfers have no throughput, so compare their time
+        if r['bytes'] == 0:
+            new_val, old_val = 1 / r['seconds'], 1 / prev['seconds']
+        else:
+            new_val, old_val = r['throughput'], prev['throughput']
+
+        change = (new_val - old_val) / old_val * 100
+
+        if change < -tolerance:
+            regressions.append(
+                f"{r['command']} {TYPE_NAMES[r['width']]} {r['bytes']} bytes: "
+                f"{change:.1f}%"
+            )
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmark the serial bootloader protocol'
+    )
+    parser.add_argument(
+        '-p', '--port',
+        dest='port', type=str, default=DEV,
+        help=f'Serial device (default {DEV})'
+    )
+    parser.add_argument(
+        '--baud',
+        dest='baud', type=int, default=BAUD,
+        help=f'Baud rate (default {BAUD})'
+    )
+    parser.add_argument(
+        '-a', '--addr',
+        dest='addr', type=str, default=DEFAULT_ADDR,
+        help='Address of RAM that can be used as scratch space (default '
+             f'{DEFAULT_ADDR})'
+    )
+    parser.add_argument(
+        '-s', '--sizes',
+        dest='sizes', type=str, default=DEFAULT_SIZES,
+        help='Comma separated list of payload sizes in bytes (default '
+             f'{DEFAULT_SIZES})'
+    )
+    parser.add_argument(
+        '-c', '--commands',
+        dest='commands', type=str, default=','.join(COMMANDS),
+        help='Comma separated list of commands to run (default all)'
+    )
+    parser.add_argument(
+        '-n', '--repeat',
+        dest='repeat', type=int, default=DEFAULT_REPEAT,
+        help='Number of times each transfer is repeated, the fastest is '
+             f'recorded (default {DEFAULT_REPEAT})'
+    )
+    parser.add_argument(
+        '-o', '--output',
+        dest='output', type=str, default=None,
+        help='Filename into which JSON results are written'
+    )
+    parser.add_argument(
+        '-b', '--baseline',
+        dest='baseline', type=str, default=None,
+        help='Filename of previous JSON results to compare against'
+    )
+    parser.add_argument(
+        '-t', '--tolerance',
+        dest='tolerance', type=float, default=DEFAULT_TOLERANCE,
+        help='Percentage drop in throughput from the baseline that is '
+             f'reported as a regression (default {DEFAULT_TOLERANCE})'
+    )
+    args = parser.parse_args()
+
+    addr = convert_arg_to_long(args.addr)
+    sizes = sorted(set(int(s, 0) for s in args.sizes.split(',')))
+    commands = [c.strip().upper() for c in args.commands.split(',')]
+
+    for command in commands:
+        if command not in COMMANDS:
+            raise ValueError(f'Unknown command {command}')
+
+    if addr & 0x3:
+        raise ValueError('Scratch address must be long aligned')
+
+    link = BootloaderLink(args.port, args.baud)
+
+    if not link.ping():
+        print('Bootloader is not responding')
+
+        return 1
+
+    # The round trip of a ping gives the latency of the link itself
+    pings = []
+
+    for _ in range(max(args.repeat, 10)):
+        start = time.perf_counter()
+        link.ping(retries=1)
+        pings.append(time.perf_counter() - start)
+
+    results = {
+        'meta': {
+            'port': args.port,
+            'baud': args.baud,
+            'line_rate': link.line_rate,
+            'repeat': args.repeat,
+            'time': time.strftime('%Y-%m-%dT%H:%M:%S'),
+            'ping_seconds': min(pings),
+        },
+        'results': [],
+        'summary': [],
+    }
+
+    print(f'Line rate {link.line_rate:.0f} B/s, ping {min(pings) * 1000:.2f} ms')
+    print()
+    print(f"{'Command':10} {'Type':4} {'Bytes':>7} {'Time (ms)':>10} "
+          f"{'B/s':>8} {'Line %':>7}")
+
+    for command in commands:
+        # Loading code only moves bytes
+        widths = [1] if command == 'LOAD_CODE' else list(TYPE_NAMES)
+
+        for width in widths:
+            points = []
+
+            for size in sizes:
+                size -= size % width
+
+                best = min(
+                    run_one(link, command, width, addr, size)
+                    for _ in range(args.repeat)
+                )
+
+                throughput = size / best
+                efficiency = throughput / link.line_rate * 100
+
+                results['results'].append({
+                    'command': command,
+                    'width': width,
+                    'bytes': size,
+                    'seconds': best,
+                    'throughput': throughput,
+                    'efficiency': efficiency,
+                })
+                points.append((size, best))
+
+                print(f'{command:10} {TYPE_NAMES[width]:4} {size:7} '
+                      f'{best * 1000:10.2f} {throughput:8.0f} '
+                      f'{efficiency:6.1f}%')
+
+            overhead, rate = fit(points)
+
+            results['summary'].append({
+                'command': command,
+                'width': width,
+                'overhead_seconds': overhead,
+                'asymptotic_throughput': rate,
+            })
+
+    link.close()
+
+    print()
+    print(f"{'Command':10} {'Type':4} {'Overhead (ms)':>14} {'Peak B/s':>9} "
+          f"{'Line %':>7}")
+
+    for s in results['summary']:
+        if s['overhead_seconds'] is None or s['asymptotic_throughput'] is None:
+            continue
+
+        print(f"{s['command']:10} {TYPE_NAMES[s['width']]:4} "
+              f"{s['overhead_seconds'] * 1000:14.2f} "
+              f"{s['asymptotic_throughput']:9.0f} "
+              f"{s['asymptotic_throughput'] / link.line_rate * 100:6.1f}%")
+
+    if args.output is not None:
+        with open(args.output, 'w') as f:
+            json.dump(results, f, indent=4)
+
+    if args.baseline is not None:
+        with open(args.baseline, 'r') as f:
+            baseline = json.load(f)
+
+        regressions = compare(results, baseline, args.tolerance)
+
+        print()
+
+        if regressions:
+            print(f'Regressions against {args.baseline}:')
+
+            for r in regressions:
+                print(f'  {r}')
+
+            return 1
+
+        print(f'No regressions against {args.baseline}')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,158 @@
+# Read the start up profile recorded by crt0.S and libcomet via the bootloader
+#
+# When built with make BOOT_PROFILE=1, timer 0 of the DP8570A is started at
+# reset, and the time at which each stage of start up finishes is recorded in
+# the .bootprof section at the start of RAM (see libcomet/bootprof.h):
+#
+#   magic "BPRF", tick rate (32 bits), record count (8 bits), room for records
+#   (8 bits), timer wraps (16 bits), records (32 bits each)
+#
+# Each record holds the stage in its top 8 bits and the time since reset, in
+# ticks, in the low 24. All values are most significant byte first.
+#
+# By default the bootloader's own profile is read, which shows how long the
+# board takes from reset to being ready for commands. Given the ELF file of a
+# program that has been run, its profile is found from the bootprof symbol
+# instead.
+
+import argparse
+import json
+import struct
+import sys
+
+from bootproto import BootloaderLink, BootloaderError
+from imagefile import ElfFile, ImageError
+from loader4 import DEV, BAUD, convert_arg_to_long
+
+BOOTPROF_MAGIC = b'BPRF'
+BOOTPROF_HEADER = '>4sLBBH'
+BOOTPROF_HEADER_LEN = struct.calcsize(BOOTPROF_HEADER)
+BOOTPROF_MAX = 16
+
+# Start of RAM in platform.ld, where the bootloader's profile is
+DEFAULT_ADDR = '0x3FFF00'
+
+# Stage numbers, mirroring the BOOTPROF_ defines in bootprof.h
+STAGES = {
+    1: 'dram',
+    2: 'unpack',
+    3: 'vectors',
+    4: 'bss',
+    5: 'data',
+    6: 'ctors',
+    7: 'devicetree',
+    8: 'drivers',
+    9: 'ready',
+}
+
+
+def stage_name(stage: int) -> str:
+    return STAGES.get(stage, f'stage {stage}')
+
+
+def decode(data: bytes) -> tuple:
+    """ Returns the tick rate and a list of (stage, ticks) """
+    magic, hz, count, room, _ = struct.unpack_from(BOOTPROF_HEADER, data)
+
+    if magic != BOOTPROF_MAGIC:
+        raise ImageError('No start up profile found (was it built with '
+                         'make BOOT_PROFILE=1?)')
+
+    count = min(count, room, (len(data) - BOOTPROF_HEADER_LEN) // 4)
+    records = []
+
+    for rec in struct.unpack_from(f'>{count}L', data, BOOTPROF_HEADER_LEN):
+        records.append((rec >> 24, rec & 0xFFFFFF))
+
+    return hz, records
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Read the start up profile via the bootloader'
+    )
+    parser.add_argument(
+        'elf',
+        type=str, nargs='?', default=None,
+        help='ELF file of a program that has been run, to read its profile '
+             'rather than the bootloader\'s'
+    )
+    parser.add_argument(
+        '-p', '--port',
+        dest='port', type=str, default=DEV,
+        help=f'Serial device (default {DEV})'
+    )
+    parser.add_argument(
+        '--baud',
+        dest='baud', type=int, default=BAUD,
+        help=f'Baud rate (default {BAUD})'
+    )
+    parser.add_argument(
+        '-a', '--addr',
+        dest='addr', type=str, default=None,
+        help=f'Address of the profile (default {DEFAULT_ADDR}, or found from '
+             'the ELF file)'
+    )
+    parser.add_argument(
+        '-j', '--json',
+        dest='json_flag', action='store_true', default=False,
+        help='Write the profile as JSON, e.g. to compare boots'
+    )
+    args = parser.parse_args()
+
+    if args.addr is not None:
+        addr = convert_arg_to_long(args.addr)
+    elif args.elf is not None:
+        symbol = ElfFile(args.elf).symbol('bootprof')
+
+        if symbol is None:
+            raise ImageError(f'{args.elf} has no bootprof symbol')
+
+        addr = symbol.value
+    else:
+        addr = convert_arg_to_long(DEFAULT_ADDR)
+
+    link = BootloaderLink(args.port, args.baud)
+
+    if not link.ping():
+        print('Bootloader is not responding')
+
+        return 1
+
+    data = link.read_mem(addr, (BOOTPROF_HEADER_LEN // 4) + BOOTPROF_MAX, 4)
+    link.close()
+
+    hz, records = decode(data)
+    stages = []
+    last = 0
+
+    for stage, ticks in records:
+        at = ticks * 1e6 / hz
+        stages.append({
+            'stage': stage_name(stage),
+            'at_us': round(at),
+            'took_us': round(at - last),
+        })
+        last = at
+
+    if args.json_flag:
+        print(json.dumps({'hz': hz, 'stages': stages}, indent=2))
+
+        return 0
+
+    print(f'{"stage":12}  {"at us":>10}  {"took us":>10}')
+
+    for s in stages:
+        share = s['took_us'] * 100 / last if last else 0
+        print(f'{s["stage"]:12}  {s["at_us"]:10}  {s["took_us"]:10}  '
+              f'{share:3.0f}%')
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (BootloaderError, ImageError, ValueError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,165 @@
+# Host side of the serial bootloader protocol
+#
+# This module wraps the commands understood by the bootloader in main.c so that
+# tools other than loader4.py can drive it. Command and response codes mirror
+# the COMMAND_ enum in main.c.
+#
+# Each command is also available split in two halves (send_ and recv_), which
+# allows a caller to queue the next command while the response to the previous
+# one is still arriving. The UART receive FIFO is 16 bytes deep and the
+# bootloader does not read it while it is transmitting, so no more than one
+# command should be queued ahead in this way.
+
+import struct
+import time
+from serial import Serial
+
+COMMAND_RX_PING = 1
+COMMAND_TX_PONG = 2
+COMMAND_RX_LOAD_CODE = 3
+COMMAND_TX_CODE_LOADED = 4
+COMMAND_RX_EXECUTE = 5
+COMMAND_RX_JUMP = 6
+COMMAND_TX_RUNNING = 7
+COMMAND_RX_READ_MEM = 8
+COMMAND_TX_READ_MEM = 9
+COMMAND_RX_WRITE_MEM = 10
+COMMAND_TX_WRITE_MEM = 11
+COMMAND_RX_READ_BLOCK = 12
+COMMAND_TX_READ_BLOCK = 13
+
+# Data types accepted by the read and write commands, by width in bytes
+WIDTHS = (1, 2, 4)
+
+# Length of the header sent with each read or write command: command, type,
+# count and address
+RW_HEADER_LEN = 10
+
+
+class BootloaderError(Exception):
+    pass
+
+
+class BootloaderLink:
+    def __init__(self, port: str, baud: int, timeout: float = 1.0):
+        self.baud = baud
+        self.timeout = timeout
+        self.ser = Serial(port, baudrate=baud, timeout=timeout)
+
+        if self.ser.in_waiting > 0:
+            self.ser.read(size=self.ser.in_waiting)
+
+    def close(self) -> None:
+        self.ser.close()
+
+    @property
+    def line_rate(self) -> float:
+        """ Bytes per second the line can carry, assuming 8N1 framing """
+        return self.baud / 10
+
+    def _send(self, data: bytes) -> None:
+        self.ser.write(data)
+        self.ser.flush()
+
+    def _recv(self, size: int, what: str) -> bytes:
+        """ Receive exactly size bytes, allowing the normal timeout per byte
+        time on top of the time the line needs to carry them """
+        deadline = time.monotonic() + self.timeout + (size / self.line_rate)
+        data = bytearray()
+
+        while len(data) < size:
+            data += self.ser.read(size=size - len(data))
+
+            if len(data) < size and time.monotonic() > deadline:
+                raise BootloaderError(
+                    f'{what}: received {len(data)} of {size} bytes'
+                )
+
+        return bytes(data)
+
+    def _expect(self, code: int, what: str) -> None:
+        rx = self._recv(1, what)
+
+        if rx[0] != code:
+            raise BootloaderError(
+                f'{what}: expected response {code}, got {rx[0]}'
+            )
+
+    def drain(self, quiet: float = 0.1) -> None:
+        """ Discard anything received until the line has been quiet for the
+        given time, e.g. responses to commands abandoned part way through """
+        timeout = self.ser.timeout
+        self.ser.timeout = quiet
+
+        while len(self.ser.read(size=4096)) > 0:
+            pass
+
+        self.ser.timeout = timeout
+
+    def ping(self, retries: int = 10) -> bool:
+        for _ in range(retries):
+            self._send(bytes([COMMAND_RX_PING]))
+
+            if self.ser.read(size=1) == bytes([COMMAND_TX_PONG]):
+                return True
+
+        return False
+
+    def load_code(self, addr: int, data: bytes) -> None:
+        self._send(
+            bytes([COMMAND_RX_LOAD_CODE]) +
+            struct.pack('>LL', len(data), addr) +
+            data
+        )
+        self._expect(COMMAND_TX_CODE_LOADED, 'load code')
+
+    def send_read(self, addr: int, count: int, width: int = 1,
+                  block: bool = False) -> None:
+        """ Request count items of width bytes from addr. With block set, the
+        address is not incremented between items. """
+        if width not in WIDTHS:
+            raise ValueError(f'Invalid width {width}')
+
+        cmd = COMMAND_RX_READ_BLOCK if block else COMMAND_RX_READ_MEM
+
+        self._send(bytes([cmd, width]) + struct.pack('>LL', count, addr))
+
+    def recv_read(self, count: int, width: int = 1) -> bytes:
+        # READ_BLOCK is acknowledged with the same code as READ_MEM
+        self._expect(COMMAND_TX_READ_MEM, 'read')
+
+        return self._recv(count * width, 'read')
+
+    def read_mem(self, addr: int, count: int, width: int = 1,
+                 block: bool = False) -> bytes:
+        self.send_read(addr, count, width, block)
+
+        return self.recv_read(count, width)
+
+    def send_write(self, addr: int, data: bytes, width: int = 1) -> None:
+        if width not in WIDTHS:
+            raise ValueError(f'Invalid width {width}')
+
+        if len(data) % width != 0:
+            raise ValueError(f'Data is not a multiple of {width} bytes')
+
+        self._send(
+            bytes([COMMAND_RX_WRITE_MEM, width]) +
+            struct.pack('>LL', len(data) // width, addr) +
+            data
+        )
+
+    def recv_write(self) -> None:
+        self._expect(COMMAND_TX_WRITE_MEM, 'write')
+
+    def write_mem(self, addr: int, data: bytes, width: int = 1) -> None:
+        self.send_write(addr, data, width)
+        self.recv_write()
+
+    def execute(self, addr: int) -> None:
+        self._send(bytes([COMMAND_RX_EXECUTE]) + struct.pack('>L', addr))
+        self._expect(COMMAND_TX_RUNNING, 'execute')
+
+    def jump(self, addr: int) -> None:
+        self._send(bytes([COMMAND_RX_JUMP]) + struct.pack('>L', addr))
+        self._expect(COMMAND_TX_RUNNING, 'jump')
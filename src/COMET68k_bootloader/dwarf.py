@@ -0,0 +1,640 @@
+# Minimal reader for the DWARF debugging information in an ELF file
+#
+# Only as much of DWARF (versions 2 to 5) is understood as is needed to find the
+# global and static variables of a program and describe their types, so that
+# their contents can be decoded from raw memory. Line numbers, call frames,
+# location lists and so on are ignored.
+#
+# The types of variables are turned into the small set of classes below, with
+# typedefs and type qualifiers (const, volatile) looked through.
+
+import copy
+
+from imagefile import ElfFile
+
+DW_TAG_array_type = 0x01
+DW_TAG_enumeration_type = 0x04
+DW_TAG_member = 0x0D
+DW_TAG_pointer_type = 0x0F
+DW_TAG_compile_unit = 0x11
+DW_TAG_structure_type = 0x13
+DW_TAG_subroutine_type = 0x15
+DW_TAG_typedef = 0x16
+DW_TAG_union_type = 0x17
+DW_TAG_subrange_type = 0x21
+DW_TAG_base_type = 0x24
+DW_TAG_const_type = 0x26
+DW_TAG_enumerator = 0x28
+DW_TAG_variable = 0x34
+DW_TAG_volatile_type = 0x35
+DW_TAG_restrict_type = 0x37
+DW_TAG_atomic_type = 0x47
+
+DW_AT_location = 0x02
+DW_AT_name = 0x03
+DW_AT_byte_size = 0x0B
+DW_AT_bit_offset = 0x0C
+DW_AT_bit_size = 0x0D
+DW_AT_const_value = 0x1C
+DW_AT_upper_bound = 0x2F
+DW_AT_count = 0x37
+DW_AT_data_member_location = 0x38
+DW_AT_encoding = 0x3E
+DW_AT_specification = 0x47
+DW_AT_type = 0x49
+DW_AT_data_bit_offset = 0x6B
+DW_AT_str_offsets_base = 0x72
+
+DW_ATE_boolean = 0x02
+DW_ATE_float = 0x04
+DW_ATE_signed = 0x05
+DW_ATE_signed_char = 0x06
+DW_ATE_unsigned = 0x07
+DW_ATE_unsigned_char = 0x08
+DW_ATE_UTF = 0x10
+
+DW_OP_addr = 0x03
+DW_OP_plus_uconst = 0x23
+
+DW_FORM_implicit_const = 0x21
+DW_FORM_indirect = 0x16
+
+DW_UT_skeleton = 0x04
+DW_UT_split_compile = 0x05
+DW_UT_type = 0x02
+DW_UT_split_type = 0x06
+
+TYPE_TAGS = (DW_TAG_typedef, DW_TAG_const_type, DW_TAG_volatile_type,
+             DW_TAG_restrict_type, DW_TAG_atomic_type)
+
+
+class DwarfError(Exception):
+    pass
+
+
+class Reader:
+    """ Cursor over a section of the file, reading values in the byte order of
+    the ELF file """
+    def __init__(self, data: bytes, endian: str, pos: int = 0):
+        self.data = data
+        self.endian = endian
+        self.pos = pos
+
+    def uint(self, size: int) -> int:
+        order = 'little' if self.endian == '<' else 'big'
+        val = int.from_bytes(self.data[self.pos:self.pos + size], order)
+        self.pos += size
+
+        return val
+
+    def bytes(self, size: int) -> bytes:
+        val = self.data[self.pos:self.pos + size]
+        self.pos += size
+
+        return val
+
+    def uleb(self) -> int:
+        val = 0
+        shift = 0
+
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            val |= (b & 0x7F) << shift
+            shift += 7
+
+            if not (b & 0x80):
+                return val
+
+    def sleb(self) -> int:
+        val = 0
+        shift = 0
+
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            val |= (b & 0x7F) << shift
+            shift += 7
+
+            if not (b & 0x80):
+                if b & 0x40:
+                    val -= 1 << shift
+
+                return val
+
+    def cstring(self) -> str:
+        end = self.data.index(b'\x00', self.pos)
+        val = self.data[self.pos:end].decode('latin-1')
+        self.pos = end + 1
+
+        return val
+
+
+class Die:
+    def __init__(self, offset: int, tag: int, parent):
+        self.offset = offset
+        self.tag = tag
+        self.parent = parent
+        self.attrs = {}
+        self.children = []
+
+    @property
+    def name(self) -> str:
+        return self.attrs.get(DW_AT_name)
+
+
+class Strx:
+    """ Placeholder for a string given as an index into .debug_str_offsets,
+    resolved once the base of the unit's offsets is known """
+    def __init__(self, index: int):
+        self.index = index
+
+
+class BaseType:
+    def __init__(self, name: str, size: int, encoding: int):
+        self.name = name
+        self.size = size
+        self.encoding = encoding
+
+    @property
+    def is_char(self) -> bool:
+        return self.size == 1 and self.encoding in (
+            DW_ATE_signed_char, DW_ATE_unsigned_char
+        )
+
+
+class PointerType:
+    def __init__(self, name: str, size: int):
+        self.name = name
+        self.size = size
+
+
+class EnumType:
+    def __init__(self, name: str, size: int, signed: bool, values: dict):
+        self.name = name
+        self.size = size
+        self.signed = signed
+        self.values = values
+
+
+class ArrayType:
+    def __init__(self, element, count: int):
+        self.element = element
+        self.count = count
+        self.size = element.size * count
+
+        # The dimensions of nested arrays are listed outermost first
+        if isinstance(element, ArrayType):
+            self.base = element.base
+            self.dims = f'[{count}]{element.dims}'
+        else:
+            self.base = element.name
+            self.dims = f'[{count}]'
+
+        self.name = self.base + self.dims
+
+
+class Member:
+    def __init__(self, name: str, offset: int, mtype, bit_size: int = None,
+                 bit_offset: int = None):
+        self.name = name
+        self.offset = offset
+        self.type = mtype
+        self.bit_size = bit_size
+        self.bit_offset = bit_offset
+
+
+class StructType:
+    def __init__(self, name: str, size: int, members: list, union: bool):
+        self.name = name
+        self.size = size
+        self.members = members
+        self.union = union
+
+
+class OpaqueType:
+    """ Anything that cannot be decoded further, which is shown as raw bytes """
+    def __init__(self, name: str, size: int):
+        self.name = name
+        self.size = size
+
+
+class Variable:
+    def __init__(self, name: str, addr: int, vtype):
+        self.name = name
+        self.addr = addr
+        self.type = vtype
+
+
+class DwarfInfo:
+    def __init__(self, elf: ElfFile):
+        self.elf = elf
+        self.endian = elf.endian
+        self.dies = {}
+        self.units = []
+        self.address_size = 8 if elf.is64 else 4
+        self._types = {}
+
+        info = elf.section('.debug_info')
+
+        if info is None:
+            return
+
+        self.info = elf.section_data(info)
+        self.abbrev = self._section('.debug_abbrev')
+        self.str = self._section('.debug_str')
+        self.line_str = self._section('.debug_line_str')
+        self.str_offsets = self._section('.debug_str_offsets')
+
+        self._parse()
+
+    @property
+    def present(self) -> bool:
+        return len(self.units) > 0
+
+    def _section(self, name: str) -> bytes:
+        s = self.elf.section(name)
+
+        return b'' if s is None else self.elf.section_data(s)
+
+    def _abbrevs(self, offset: int) -> dict:
+        r = Reader(self.abbrev, self.endian, offset)
+        table = {}
+
+        while True:
+            code = r.uleb()
+
+            if code == 0:
+                return table
+
+            tag = r.uleb()
+            children = r.uint(1) != 0
+            specs = []
+
+            while True:
+                attr = r.uleb()
+                form = r.uleb()
+
+                if attr == 0 and form == 0:
+                    break
+
+                const = r.sleb() if form == DW_FORM_implicit_const else None
+                specs.append((attr, form, const))
+
+            table[code] = (tag, children, specs)
+
+    def _parse(self) -> None:
+        r = Reader(self.info, self.endian)
+
+        while r.pos < len(self.info):
+            unit_offset = r.pos
+            length = r.uint(4)
+            offset_size = 4
+
+            if length == 0xFFFFFFFF:
+                length = r.uint(8)
+                offset_size = 8
+
+            end = r.pos + length
+            version = r.uint(2)
+
+            if version < 2 or version > 5:
+                raise DwarfError(f'DWARF version {version} is not supported')
+
+            if version >= 5:
+                unit_type = r.uint(1)
+                address_size = r.uint(1)
+                abbrev_offset = r.uint(offset_size)
+
+                if unit_type in (DW_UT_skeleton, DW_UT_split_compile):
+                    r.pos += 8
+                elif unit_type in (DW_UT_type, DW_UT_split_type):
+                    r.pos += 8 + offset_size
+            else:
+                abbrev_offset = r.uint(offset_size)
+                address_size = r.uint(1)
+
+            self.address_size = address_size
+
+            unit = self._parse_unit(
+                r, end, unit_offset, version, address_size, offset_size,
+                self._abbrevs(abbrev_offset)
+            )
+
+            if unit is not None:
+                self.units.append(unit)
+
+            r.pos = end
+
+    def _parse_unit(self, r: Reader, end: int, unit_offset: int,
+                    version: int, address_size: int, offset_size: int,
+                    abbrevs: dict) -> Die:
+        top = None
+        parent = None
+        strx = []
+
+        while r.pos < end:
+            offset = r.pos
+            code = r.uleb()
+
+            if code == 0:
+                if parent is None:
+                    break
+
+                parent = parent.parent
+                continue
+
+            tag, children, specs = abbrevs[code]
+            die = Die(offset, tag, parent)
+
+            for attr, form, const in specs:
+                val = self._form(
+                    r, form, const, unit_offset, version, address_size,
+                    offset_size
+                )
+
+                if isinstance(val, Strx):
+                    strx.append((die, attr, val))
+
+                die.attrs[attr] = val
+
+            self.dies[offset] = die
+
+            if parent is None:
+                top = die
+            else:
+                parent.children.append(die)
+
+            if children:
+                parent = die
+            elif parent is None:
+                break
+
+        if top is not None and strx:
+            base = top.attrs.get(DW_AT_str_offsets_base, 8)
+
+            for die, attr, val in strx:
+                sr = Reader(self.str_offsets, self.endian,
+                            base + val.index * offset_size)
+                die.attrs[attr] = Reader(
+                    self.str, self.endian, sr.uint(offset_size)
+                ).cstring()
+
+        return top
+
+    def _form(self, r: Reader, form: int, const: int, unit_offset: int,
+              version: int, address_size: int, offset_size: int):
+        if form == DW_FORM_indirect:
+            form = r.uleb()
+
+        if form == 0x01:                        # addr
+            return r.uint(address_size)
+        if form in (0x0B, 0x11):                # data1, ref1
+            val = r.uint(1)
+        elif form in (0x05, 0x12):              # data2, ref2
+            val = r.uint(2)
+        elif form in (0x06, 0x13):              # data4, ref4
+            val = r.uint(4)
+        elif form in (0x07, 0x14, 0x20):        # data8, ref8, ref_sig8
+            val = r.uint(8)
+        elif form in (0x0F, 0x15):              # udata, ref_udata
+            val = r.uleb()
+        elif form == 0x0D:                      # sdata
+            return r.sleb()
+        elif form == 0x0C:                      # flag
+            return r.uint(1) != 0
+        elif form == 0x19:                      # flag_present
+            return True
+        elif form == 0x08:                      # string
+            return r.cstring()
+        elif form == 0x0E:                      # strp
+            return Reader(self.str, self.endian, r.uint(offset_size)).cstring()
+        elif form == 0x1F:                      # line_strp
+            return Reader(
+                self.line_str, self.endian, r.uint(offset_size)
+            ).cstring()
+        elif form == 0x1A:                      # strx
+            return Strx(r.uleb())
+        elif form in (0x25, 0x26, 0x27, 0x28):  # strx1 - strx4
+            return Strx(r.uint(form - 0x24))
+        elif form == 0x10:                      # ref_addr
+            return r.uint(address_size if version == 2 else offset_size)
+        elif form in (0x17, 0x1D):              # sec_offset, strp_sup
+            return r.uint(offset_size)
+        elif form == 0x1C:                      # ref_sup4
+            return r.uint(4)
+        elif form == 0x24:                      # ref_sup8
+            return r.uint(8)
+        elif form in (0x09, 0x18):              # block, exprloc
+            return r.bytes(r.uleb())
+        elif form == 0x0A:                      # block1
+            return r.bytes(r.uint(1))
+        elif form == 0x03:                      # block2
+            return r.bytes(r.uint(2))
+        elif form == 0x04:                      # block4
+            return r.bytes(r.uint(4))
+        elif form == 0x1E:                      # data16
+            return r.bytes(16)
+        elif form in (0x1B, 0x22, 0x23):        # addrx, loclistx, rnglistx
+            return r.uleb()
+        elif form in (0x29, 0x2A, 0x2B, 0x2C):  # addrx1 - addrx4
+            return r.uint(form - 0x28)
+        elif form == DW_FORM_implicit_const:
+            return const
+        else:
+            raise DwarfError(f'Unknown attribute form 0x{form:02X}')
+
+        # References within the unit are made relative to .debug_info
+        if form in (0x11, 0x12, 0x13, 0x14, 0x15):
+            val += unit_offset
+
+        return val
+
+    def _location(self, die: Die) -> int:
+        """ Return the address of a variable with a fixed location """
+        expr = die.attrs.get(DW_AT_location)
+
+        if not isinstance(expr, bytes) or len(expr) != 1 + self.address_size:
+            return None
+
+        if expr[0] != DW_OP_addr:
+            return None
+
+        return Reader(expr, self.endian, 1).uint(self.address_size)
+
+    def variables(self) -> list:
+        """ Return every variable with a fixed address: globals, file level
+        statics and statics within functions """
+        result = []
+
+        for die in self.dies.values():
+            if die.tag != DW_TAG_variable:
+                continue
+
+            addr = self._location(die)
+
+            if addr is None:
+                continue
+
+            # A definition may refer back to the declaration for its name and
+            # type
+            decl = die
+
+            while decl.name is None and DW_AT_specification in decl.attrs:
+                decl = self.dies[decl.attrs[DW_AT_specification]]
+
+            if decl.name is None:
+                continue
+
+            type_die = die.attrs.get(DW_AT_type, decl.attrs.get(DW_AT_type))
+            result.append(Variable(decl.name, addr, self.type(type_die)))
+
+        return result
+
+    def type(self, offset: int):
+        """ Build the description of the type at offset in .debug_info """
+        if offset is None:
+            return OpaqueType('void', 0)
+
+        if offset not in self._types:
+            self._types[offset] = self._build_type(self.dies[offset])
+
+        return self._types[offset]
+
+    def _build_type(self, die: Die):
+        name = die.name
+        size = die.attrs.get(DW_AT_byte_size)
+
+        if die.tag in TYPE_TAGS:
+            inner = self.type(die.attrs.get(DW_AT_type))
+
+            # Typedefs keep their own name for display
+            if die.tag == DW_TAG_typedef:
+                inner = copy.copy(inner)
+                inner.name = name
+
+            return inner
+
+        if die.tag == DW_TAG_base_type:
+            return BaseType(name, size, die.attrs.get(DW_AT_encoding))
+
+        if die.tag == DW_TAG_pointer_type:
+            target = die.attrs.get(DW_AT_type)
+            target_name = 'void' if target is None else self._type_name(target)
+
+            return PointerType(f'{target_name} *', size or self.address_size)
+
+        if die.tag == DW_TAG_enumeration_type:
+            values = {}
+            signed = False
+
+            for c in die.children:
+                if c.tag == DW_TAG_enumerator:
+                    values[c.attrs.get(DW_AT_const_value)] = c.name
+                    signed |= c.attrs.get(DW_AT_const_value) < 0
+
+            return EnumType(f"enum {name or ''}".strip(), size, signed, values)
+
+        if die.tag == DW_TAG_array_type:
+            # Multi-dimensional arrays are built inside out, so that the last
+            # subrange varies fastest
+            etype = self.type(die.attrs.get(DW_AT_type))
+            counts = []
+
+            for c in die.children:
+                if c.tag != DW_TAG_subrange_type:
+                    continue
+
+                if DW_AT_count in c.attrs:
+                    counts.append(c.attrs[DW_AT_count])
+                elif isinstance(c.attrs.get(DW_AT_upper_bound), int):
+                    counts.append(c.attrs[DW_AT_upper_bound] + 1)
+                else:
+                    counts.append(0)
+
+            for count in reversed(counts):
+                etype = ArrayType(etype, count)
+
+            return etype
+
+        if die.tag in (DW_TAG_structure_type, DW_TAG_union_type):
+            union = die.tag == DW_TAG_union_type
+            kind = 'union' if union else 'struct'
+            members = []
+
+            for c in die.children:
+                if c.tag != DW_TAG_member:
+                    continue
+
+                mtype = self.type(c.attrs.get(DW_AT_type))
+                offset = self._member_offset(c)
+                bit_size = c.attrs.get(DW_AT_bit_size)
+                bit_offset = None
+
+                if bit_size is not None:
+                    if DW_AT_data_bit_offset in c.attrs:
+                        # Counted from the start of the structure
+                        bit_offset = c.attrs[DW_AT_data_bit_offset]
+                        offset = bit_offset // 8
+                        bit_offset %= 8
+                    else:
+                        # Counted from the most significant bit of a storage
+                        # unit of byte_size, which for big endian targets is
+                        # the first bit at offset
+                        unit = c.attrs.get(DW_AT_byte_size, mtype.size)
+                        bit_offset = c.attrs.get(DW_AT_bit_offset, 0)
+
+                        if self.endian == '<':
+                            bit_offset = unit * 8 - bit_offset - bit_size
+                            offset += bit_offset // 8
+                            bit_offset %= 8
+
+                members.append(Member(c.name, offset, mtype, bit_size,
+                                      bit_offset))
+
+            return StructType(f"{kind} {name or ''}".strip(), size or 0,
+                              members, union)
+
+        return OpaqueType(name or '?', size or 0)
+
+    def _member_offset(self, die: Die) -> int:
+        loc = die.attrs.get(DW_AT_data_member_location, 0)
+
+        # DWARF 2 gives the offset as an expression
+        if isinstance(loc, bytes):
+            if len(loc) > 0 and loc[0] == DW_OP_plus_uconst:
+                return Reader(loc, self.endian, 1).uleb()
+
+            return 0
+
+        return loc
+
+    def _type_name(self, offset: int) -> str:
+        die = self.dies[offset]
+        prefix = {
+            DW_TAG_const_type: 'const ',
+            DW_TAG_volatile_type: 'volatile ',
+        }.get(die.tag, '')
+
+        if die.name is not None:
+            if die.tag == DW_TAG_structure_type:
+                return f'struct {die.name}'
+            if die.tag == DW_TAG_union_type:
+                return f'union {die.name}'
+            if die.tag == DW_TAG_enumeration_type:
+                return f'enum {die.name}'
+
+            return die.name
+
+        inner = 'void'
+
+        if DW_AT_type in die.attrs:
+            inner = self._type_name(die.attrs[DW_AT_type])
+
+        if die.tag == DW_TAG_pointer_type:
+            return f'{inner} *'
+
+        if die.tag == DW_TAG_subroutine_type:
+            return f'{inner} (*)()'
+
+        return prefix + inner
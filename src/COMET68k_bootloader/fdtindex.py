@@ -0,0 +1,237 @@
+# Build a lookup index for a devicetree blob
+#
+# Finding a node with libfdt means walking the structure block of the blob tag
+# by tag, which is slow when the blob is in 8 bit ROM on the X-bus. make_image.py
+# places an index straight after the blob, and the fdt_index_ functions in
+# libfdt (fdt_index.h) use it to go straight to a node, falling back to walking
+# the blob when there is no index.
+#
+# Index layout (see libfdt/fdt_index.h):
+#
+#   header: magic "FDTI", version (16 bits), reserved (16 bits), total size of
+#           the blob, size of its structure block, then the offset from the
+#           start of the index and number of slots of each of 4 tables: paths,
+#           aliases, compatibles and phandles
+#   tables: slots of (key, value), both 32 bits
+#
+# The index starts at the first multiple of 4 bytes after the end of the blob.
+# Each table is a hash table with a power of 2 number of slots, at least twice
+# the number of entries, and collisions are resolved by trying the following
+# slots in turn. An empty slot has a value of 0xFFFFFFFF. Keys are:
+#
+#   paths: hash of the full path of each node, e.g. /xbus@c00000/serial@c20008,
+#          to the offset of the node
+#   aliases: hash of the name of each alias, to the offset of its property
+#   compatibles: hash of each string of each compatible property, to the offset
+#                of the node. A string used by several nodes has a slot for each.
+#   phandles: phandle of each node, to the offset of the node
+#
+# The hash is 32 bit FNV-1a. Offsets are those used by libfdt, from the start of
+# the structure block. All values are most significant byte first.
+#
+# Run on its own, this shows what would be indexed for a blob, or with -o writes
+# the blob followed by its index, as it would be in a ROM image:
+#
+#   python3 fdtindex.py ../devicetree/COMET68k.dtb
+#   python3 fdtindex.py ../devicetree/COMET68k.dtb -o COMET68k-index.dtb
+
+import argparse
+import struct
+import sys
+
+FDT_MAGIC = 0xD00DFEED
+FDT_HEADER_FORMAT = '>10L'
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
+INDEX_MAGIC = b'FDTI'
+INDEX_VERSION = 1
+INDEX_HEADER_FORMAT = '>4sHHLL8L'
+INDEX_HEADER_SIZE = struct.calcsize(INDEX_HEADER_FORMAT)
+SLOT_FORMAT = '>LL'
+SLOT_EMPTY = 0xFFFFFFFF
+TABLES = ('paths', 'aliases', 'compatibles', 'phandles')
+
+
+class FdtError(Exception):
+    pass
+
+
+def fnv1a(data: bytes) -> int:
+    h = 0x811C9DC5
+
+    for byte in data:
+        h = ((h ^ byte) * 0x01000193) & 0xFFFFFFFF
+
+    return h
+
+
+def align(val: int) -> int:
+    return (val + 3) & ~3
+
+
+def parse(blob: bytes) -> dict:
+    """ Walk a blob, returning the keys to index in each table, as lists of
+    (key, offset). Keys are bytes, or an int for phandles. """
+    if len(blob) < struct.calcsize(FDT_HEADER_FORMAT):
+        raise FdtError('Devicetree blob is too short')
+
+    (magic, totalsize, off_struct, off_strings, _, version, _, _, _,
+     size_struct) = struct.unpack_from(FDT_HEADER_FORMAT, blob)
+
+    if magic != FDT_MAGIC or totalsize > len(blob) or version < 17:
+        raise FdtError('Not a version 17 devicetree blob')
+
+    def string(offset: int) -> bytes:
+        return blob[offset:blob.index(b'\x00', offset)]
+
+    keys = {name: [] for name in TABLES}
+    path = []
+    offset = 0
+
+    while offset < size_struct:
+        tag_offset = offset
+        tag, = struct.unpack_from('>L', blob, off_struct + offset)
+        offset += 4
+
+        if tag == FDT_BEGIN_NODE:
+            name = string(off_struct + offset)
+            offset = align(offset + len(name) + 1)
+            path.append(name)
+            full = b'/' + b'/'.join(path[1:])
+            keys['paths'].append((full, tag_offset))
+        elif tag == FDT_END_NODE:
+            path.pop()
+        elif tag == FDT_PROP:
+            length, name_offset = struct.unpack_from('>LL', blob,
+                                                     off_struct + offset)
+            value = blob[off_struct + offset + 8:
+                         off_struct + offset + 8 + length]
+            offset = align(offset + 8 + length)
+            name = string(off_strings + name_offset)
+            node = keys['paths'][-1]
+
+            if len(path) == 2 and path[1] == b'aliases':
+                keys['aliases'].append((name, tag_offset))
+            elif name == b'compatible':
+                for compat in value.split(b'\x00')[:-1]:
+                    keys['compatibles'].append((compat, node[1]))
+            elif name in (b'phandle', b'linux,phandle') and length == 4:
+                phandle, = struct.unpack('>L', value)
+
+                if all(p != phandle for p, _ in keys['phandles']):
+                    keys['phandles'].append((phandle, node[1]))
+        elif tag == FDT_NOP:
+            pass
+        elif tag == FDT_END:
+            break
+        else:
+            raise FdtError(f'Bad tag {tag} at offset {tag_offset}')
+
+    return keys
+
+
+def hash_table(entries: list) -> bytes:
+    """ Lay out (hash, value) entries in a hash table """
+    slots = 1
+
+    while slots < len(entries) * 2:
+        slots <<= 1
+
+    table = [None] * slots
+
+    for key, value in entries:
+        pos = key & (slots - 1)
+
+        while table[pos] is not None:
+            pos = (pos + 1) & (slots - 1)
+
+        table[pos] = (key, value)
+
+    return b''.join(struct.pack(SLOT_FORMAT, *(s or (0, SLOT_EMPTY)))
+                    for s in table)
+
+
+def build(blob: bytes) -> bytes:
+    """ Build the index for a blob, to be placed at the first multiple of 4
+    bytes after its end """
+    keys = parse(blob)
+    totalsize, = struct.unpack_from('>L', blob, 4)
+    size_struct, = struct.unpack_from('>L', blob, 36)
+    tables = []
+    layout = []
+    offset = INDEX_HEADER_SIZE
+
+    for name in TABLES:
+        if name == 'phandles':
+            entries = keys[name]
+        else:
+            entries = [(fnv1a(key), value) for key, value in keys[name]]
+
+        table = hash_table(entries)
+        tables.append(table)
+        layout += [offset, len(table) // struct.calcsize(SLOT_FORMAT)]
+        offset += len(table)
+
+    header = struct.pack(INDEX_HEADER_FORMAT, INDEX_MAGIC, INDEX_VERSION, 0,
+                         totalsize, size_struct, *layout)
+
+    return header + b''.join(tables)
+
+
+def append(blob: bytes) -> bytes:
+    """ Return the blob followed by its index """
+    totalsize, = struct.unpack_from('>L', blob, 4)
+    blob = blob[:totalsize]
+
+    return blob + b'\x00' * (align(totalsize) - totalsize) + build(blob)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Show or append the lookup index for a devicetree blob'
+    )
+    parser.add_argument(
+        'blob',
+        type=str,
+        help='Devicetree blob'
+    )
+    parser.add_argument(
+        '-o', '--output',
+        dest='output', type=str, default=None,
+        help='Write the blob followed by its index to this file'
+    )
+    args = parser.parse_args()
+
+    with open(args.blob, 'rb') as f:
+        blob = f.read()
+
+    if args.output is not None:
+        with open(args.output, 'wb') as f:
+            f.write(append(blob))
+
+        return 0
+
+    keys = parse(blob)
+
+    for name in TABLES:
+        print(f'{name}:')
+
+        for key, value in keys[name]:
+            key = key if isinstance(key, int) else key.decode()
+            print(f'  {value:6}  {key}')
+
+    print(f'Index is {len(build(blob))} bytes')
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (FdtError, OSError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
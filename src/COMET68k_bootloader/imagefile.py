@@ -0,0 +1,277 @@
+# Readers for the program image formats produced by the Makefile
+#
+# ElfFile reads the 32 bit big endian ELF files produced by the m68k
+# toolchain (e.g. bmbinary), and read_srec() reads Motorola S-record files
+# (e.g. bmbinary.srec). Both produce a list of segments, each an address and
+# the bytes to be loaded there, along with the entry point if there is one.
+#
+# Only what actually needs loading ends up in a segment: gaps between sections,
+# and the zero initialised (NOBITS) part of each ELF segment, are skipped.
+
+import struct
+
+ELF_MAGIC = b'\x7fELF'
+
+PT_LOAD = 1
+
+SHT_SYMTAB = 2
+SHT_STRTAB = 3
+SHT_NOBITS = 8
+
+SHF_ALLOC = 0x2
+
+STT_OBJECT = 1
+STT_FUNC = 2
+
+
+class ImageError(Exception):
+    pass
+
+
+class ElfSection:
+    def __init__(self, name: str, sh_type: int, flags: int, addr: int,
+                 offset: int, size: int, link: int, entsize: int):
+        self.name = name
+        self.type = sh_type
+        self.flags = flags
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+        self.entsize = entsize
+
+
+class ElfSymbol:
+    def __init__(self, name: str, value: int, size: int, sym_type: int,
+                 section: str):
+        self.name = name
+        self.value = value
+        self.size = size
+        self.type = sym_type
+        self.section = section
+
+
+class ElfFile:
+    def __init__(self, filename: str):
+        with open(filename, 'rb') as f:
+            self.data = f.read()
+
+        if self.data[0:4] != ELF_MAGIC:
+            raise ImageError(f'{filename} is not an ELF file')
+
+        if self.data[4] not in (1, 2) or self.data[5] not in (1, 2):
+            raise ImageError(f'{filename} has an unknown ELF class or encoding')
+
+        # The m68k toolchain produces 32 bit big endian files, but anything
+        # else is handled as well so that host builds can be read
+        self.is64 = self.data[4] == 2
+        self.endian = '<' if self.data[5] == 1 else '>'
+        addr = 'Q' if self.is64 else 'L'
+
+        (self.type, self.machine, _, self.entry, self.phoff, self.shoff,
+         _, _, self.phentsize, self.phnum, self.shentsize, self.shnum,
+         self.shstrndx) = self.unpack(f'HHL{addr}{addr}{addr}LHHHHHH', 16)
+
+        self.sections = self._read_sections()
+        self._symbols = None
+
+    def unpack(self, fmt: str, offset: int) -> tuple:
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def _read_sections(self) -> list:
+        fmt = 'LLQQQQLLQQ' if self.is64 else 'LLLLLLLLLL'
+        raw = []
+
+        for i in range(self.shnum):
+            raw.append(self.unpack(fmt, self.shoff + i * self.shentsize))
+
+        sections = []
+        names = raw[self.shstrndx] if self.shstrndx < len(raw) else None
+
+        for (name, sh_type, flags, addr, offset, size, link, _, _,
+             entsize) in raw:
+            if names is not None:
+                name = self._string(names[4], name)
+
+            sections.append(ElfSection(
+                name, sh_type, flags, addr, offset, size, link, entsize
+            ))
+
+        return sections
+
+    def _string(self, table_offset: int, offset: int) -> str:
+        start = table_offset + offset
+        end = self.data.index(b'\x00', start)
+
+        return self.data[start:end].decode('latin-1')
+
+    def section(self, name: str) -> ElfSection:
+        for s in self.sections:
+            if s.name == name:
+                return s
+
+        return None
+
+    def section_data(self, section: ElfSection) -> bytes:
+        if section.type == SHT_NOBITS:
+            return bytes(section.size)
+
+        return self.data[section.offset:section.offset + section.size]
+
+    @property
+    def symbols(self) -> list:
+        if self._symbols is None:
+            self._symbols = []
+
+            for s in self.sections:
+                if s.type != SHT_SYMTAB:
+                    continue
+
+                strtab = self.sections[s.link]
+
+                for i in range(s.size // s.entsize):
+                    offset = s.offset + i * s.entsize
+
+                    if self.is64:
+                        (name, info, _, shndx, value, size) = self.unpack(
+                            'LBBHQQ', offset
+                        )
+                    else:
+                        (name, value, size, info, _, shndx) = self.unpack(
+                            'LLLBBH', offset
+                        )
+
+                    if name == 0:
+                        continue
+
+                    section = None
+
+                    if 0 < shndx < len(self.sections):
+                        section = self.sections[shndx].name
+
+                    self._symbols.append(ElfSymbol(
+                        self._string(strtab.offset, name), value, size,
+                        info & 0xF, section
+                    ))
+
+        return self._symbols
+
+    def symbol(self, name: str) -> ElfSymbol:
+        for s in self.symbols:
+            if s.name == name:
+                return s
+
+        return None
+
+    def read(self, addr: int, size: int) -> bytes:
+        """ Read initialised data from the allocated section containing addr,
+        as it would appear in memory at run time. Returns None if addr is not
+        within an allocated section. """
+        for s in self.sections:
+            if not (s.flags & SHF_ALLOC) or s.size == 0:
+                continue
+
+            if s.addr <= addr and addr + size <= s.addr + s.size:
+                start = addr - s.addr
+
+                return self.section_data(s)[start:start + size]
+
+        return None
+
+    def segments(self) -> list:
+        """ Return the file contents of each PT_LOAD segment, at its physical
+        (load) address """
+        segments = []
+
+        for i in range(self.phnum):
+            offset = self.phoff + i * self.phentsize
+
+            if self.is64:
+                (p_type, _, offset, _, paddr, filesz) = self.unpack(
+                    'LLQQQQ', offset
+                )
+            else:
+                (p_type, offset, _, paddr, filesz) = self.unpack(
+                    'LLLLL', offset
+                )
+
+            if p_type != PT_LOAD or filesz == 0:
+                continue
+
+            segments.append((paddr, self.data[offset:offset + filesz]))
+
+        return segments
+
+
+def read_srec(filename: str) -> tuple:
+    """ Read an S-record file, returning its data records as a list of
+    segments, along with the start address from the termination record (or
+    None) """
+    segments = []
+    entry = None
+
+    with open(filename, 'r') as f:
+        for num, line in enumerate(f, 1):
+            line = line.strip()
+
+            if line == '':
+                continue
+
+            try:
+                if line[0] != 'S':
+                    raise ValueError
+
+                rec_type = line[1]
+                raw = bytes.fromhex(line[2:])
+            except (ValueError, IndexError):
+                raise ImageError(f'{filename}:{num}: not a valid S-record')
+
+            if raw[0] != len(raw) - 1 or (sum(raw) & 0xFF) != 0xFF:
+                raise ImageError(f'{filename}:{num}: bad length or checksum')
+
+            if rec_type in '123':
+                addr_len = int(rec_type) + 1
+                addr = int.from_bytes(raw[1:1 + addr_len], 'big')
+
+                segments.append((addr, raw[1 + addr_len:-1]))
+            elif rec_type in '789':
+                addr_len = 11 - int(rec_type)
+                entry = int.from_bytes(raw[1:1 + addr_len], 'big')
+
+    return (segments, entry)
+
+
+def read_image(filename: str) -> tuple:
+    """ Read an ELF or S-record file, returning its segments and entry point,
+    or None if the file is neither """
+    with open(filename, 'rb') as f:
+        head = f.read(4)
+
+    if head == ELF_MAGIC:
+        elf = ElfFile(filename)
+
+        return (elf.segments(), elf.entry)
+
+    if len(head) >= 2 and head[0:1] == b'S' and head[1:2] in b'0123':
+        return read_srec(filename)
+
+    return None
+
+
+def coalesce(segments: list) -> list:
+    """ Sort segments by address and join together any that are adjacent, so
+    that each contiguous run of data can be sent in a single transfer """
+    result = []
+
+    for addr, data in sorted(segments, key=lambda s: s[0]):
+        if len(data) == 0:
+            continue
+
+        if result and result[-1][0] + len(result[-1][1]) == addr:
+            result[-1][1].extend(data)
+        elif result and result[-1][0] + len(result[-1][1]) > addr:
+            raise ImageError(f'Overlapping data at 0x{addr:08X}')
+        else:
+            result.append((addr, bytearray(data)))
+
+    return [(addr, bytes(data)) for addr, data in result]
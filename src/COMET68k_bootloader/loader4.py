@@ -3,6 +3,7 @@ import os
 import struct
 import time
 from serial import Serial
+from imagefile import read_image, coalesce
 
 
 # Adjust this to point to your serial device
@@ -69,7 +70,8 @@ def main():
         '-b', '--base',
         dest='base', type=str, default=None,
         help='Base address where the binary file will be loaded in RAM. Min '
-             '0, max 0xFFFFFFFE, must be word aligned'
+             '0, max 0xFFFFFFFE, must be word aligned. Not required for ELF '
+             'and S-record files, which carry their own load addresses'
     )
 
     exec_group = parser.add_mutually_exclusive_group()
@@ -117,6 +119,27 @@ def main():
         help='Read/write longs to the address specified by addr'
     )
 
+    parser.add_argument(
+        '-n', '--no-exec',
+        dest='no_exec_flag', action='store_true',
+        help='Do not execute an ELF or S-record file after loading it. By '
+             'default it is executed (JSR) from its entry point, unless '
+             '--exec or --jump is given'
+    )
+
+    parser.add_argument(
+        '--log',
+        dest='log_flag', action='store_true',
+        help='After executing an ELF file, decode binary log records sent by '
+             'LOG() (see libcomet/log.h) using its format strings'
+    )
+
+    parser.add_argument(
+        '-p', '--port',
+        dest='port', type=str, default=DEV,
+        help=f'Serial device (default {DEV})'
+    )
+
     parser.add_argument(
         '--block',
         dest='block_flag', action='store_true',
@@ -127,7 +150,8 @@ def main():
         'data',
         type=str, nargs='?',
         help='When specifying --base, this argument contains the filename of '
-             'the binary to be loaded into memory. When specifying --addr and '
+             'the binary to be loaded into memory. An ELF or S-record file '
+             'may be given without --base. When specifying --addr and '
              '--write, this argument contains hex formatted data that is to '
              'be written to memory. If specifying --addr and --read, this '
              'argument contains the filename into which the read data will be '
@@ -147,7 +171,12 @@ def main():
     word_flag = args.word_flag
     long_flag = args.long_flag
     block_flag = args.block_flag
+    no_exec_flag = args.no_exec_flag
+    log_flag = args.log_flag
     data = args.data
+    port = args.port
+    segments = None
+    decoder = None
 
     if addr is not None:
         # Performing a memory read or write
@@ -224,6 +253,44 @@ def main():
         
         length_be = struct.pack('>L', length)
         addr_be = struct.pack('>L', convert_arg_to_long(addr))
+    elif base is None and data is not None:
+        # Loading an ELF or S-record file. Only the contents of each loadable
+        # segment are sent, adjacent segments being combined into a single
+        # transfer, so gaps between sections and zero initialised data cost
+        # nothing.
+        image = read_image(data)
+
+        if image is None:
+            raise ValueError(
+                f'{data} is not an ELF or S-record file. Specify --base to '
+                'load a binary file.'
+            )
+
+        if rd_flag is True or wr_flag is True:
+            print(
+                '--read and --write are ignored during binary load. '
+                '--write assumed.'
+            )
+
+        segments = coalesce(image[0])
+        entry = image[1]
+
+        if len(segments) == 0:
+            raise ValueError(f'{data} contains nothing to load')
+
+        if log_flag:
+            # Imported here as logdecode itself uses this module
+            from logdecode import LogDecoder
+
+            decoder = LogDecoder(data)
+
+        length = sum(len(seg) for _, seg in segments)
+
+        if exec is None and jump is None and no_exec_flag is False:
+            if entry is None:
+                print(f'{data} has no entry point, it will not be executed')
+            else:
+                exec = f'0x{entry:X}'
     elif base is not None:
         # Loading binary
         base = convert_arg_to_long(base)
@@ -243,6 +310,12 @@ def main():
         if base & 0x1 == 1:
             raise ValueError('Base must be word aligned')
 
+        with open(data, 'rb') as file:
+            if file.read(4) == b'\x7fELF':
+                raise ValueError(
+                    f'{data} is an ELF file, do not specify --base to load it'
+                )
+
         length = os.stat(data).st_size
 
         if not (2 <= length <= 0x100000000):
@@ -259,9 +332,6 @@ def main():
 
         with open(data, 'r+b') as file:
             data_wr = file.read(length)
-        
-        base_be = struct.pack('>L', convert_arg_to_long(base))
-        length_be = struct.pack('>L', length)
 
     if exec is not None:
         # Performing a JSR
@@ -279,7 +349,7 @@ def main():
     ######################################
     # Establish connection with bootloader
     ser = Serial(
-        DEV,
+        port,
         baudrate=BAUD,
         timeout=1
     )
@@ -450,35 +520,50 @@ def main():
                         return
 
             print(' OK')
-    elif base is not None:
+    elif base is not None or segments is not None:
         # Send the code over
         start = time.time()
 
-        print(f'Loading {length} bytes to 0x{base:08X}:', end='', flush=True)
+        if segments is None:
+            print(f'Loading {length} bytes to 0x{base:08X}:', end='', flush=True)
 
-        data_tx = bytes(b'\x03' + length_be + base_be + data_wr)
+            segments = [(base, data_wr)]
+        else:
+            print(
+                f'Loading {length} bytes in {len(segments)} segment(s):',
+                end='',
+                flush=True
+            )
 
-        ser.write(data_tx)
-        ser.flush()
+        for seg_addr, seg_data in segments:
+            if len(segments) > 1:
+                print(f' 0x{seg_addr:08X}', end='', flush=True)
 
-        failed = 0
+            data_tx = bytes(
+                b'\x03' + struct.pack('>LL', len(seg_data), seg_addr) + seg_data
+            )
 
-        while True:
-            try:
-                if ord(ser.read(size=1)) == 4:
-                    break
-            except TypeError:
-                if failed == 0:
-                    print(' ', end='')
+            ser.write(data_tx)
+            ser.flush()
+
+            failed = 0
 
-                failed += 1
+            while True:
+                try:
+                    if ord(ser.read(size=1)) == 4:
+                        break
+                except TypeError:
+                    if failed == 0:
+                        print(' ', end='')
+
+                    failed += 1
 
-                print('.', end='', flush=True)
+                    print('.', end='', flush=True)
 
-                if failed == 15:
-                    print(' Failed: transfer not acknowledged')
+                    if failed == 15:
+                        print(' Failed: transfer not acknowledged')
 
-                    return
+                        return
 
         duration = time.time() - start
 
@@ -526,6 +611,14 @@ def main():
             print('============================================================')
             while True:
                 try:
+                    if decoder is not None:
+                        # Binary log records are decoded, and any other
+                        # output passed through
+                        rx = ser.read(size=max(1, ser.in_waiting))
+                        print(decoder.feed(rx), end='', flush=True)
+
+                        continue
+
                     char = int.from_bytes(ser.read(size=1), "little")
 
                     if char in [0x0D]:
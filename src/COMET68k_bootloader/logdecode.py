@@ -0,0 +1,250 @@
+# Decode binary log records sent by a program using LOG() from libcomet
+#
+# Each record holds the ID of a format string, a timestamp and the raw values
+# of the arguments. The format strings are read from the .logstr section of the
+# program's ELF file, and the records are turned back into lines of text here.
+#
+# Record layout (see libcomet/log.h):
+#
+#   sync (0x1E), argument count, ID (16 bits), timestamp (32 bits),
+#   arguments (32 bits each), checksum
+#
+# All values are most significant byte first. The checksum makes the bytes
+# after the sync add up to zero. Anything received outside of a record is
+# treated as plain text and passed through, so programs can mix LOG() with
+# ordinary output.
+
+import argparse
+import re
+import sys
+
+from imagefile import ElfFile, ImageError
+from loader4 import DEV, BAUD
+
+LOG_SYNC = 0x1E
+LOG_HEADER_LEN = 8
+LOG_MAX_ARGS = 6
+LOG_ID_DROPPED = 0xFFFF
+
+MAX_STRING = 256
+
+SPEC_RE = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d*))?(hh|h|ll|l|z|t|j)?([diouxXcsp%])')
+
+
+class LogDecoder:
+    def __init__(self, filename: str):
+        self.elf = ElfFile(filename)
+        section = self.elf.section('.logstr')
+
+        if section is None:
+            raise ImageError(f'{filename} has no .logstr section')
+
+        self.strings = self.elf.section_data(section)
+
+        # IDs are the low 16 bits of each string's address, which is also its
+        # offset when the section is linked at 0 as in platform.ld
+        self.base = section.addr & 0xFFFF
+        self.buf = bytearray()
+        self.column = 0
+        self.records = 0
+        self.errors = 0
+
+    def format_string(self, id: int) -> str:
+        offset = (id - self.base) & 0xFFFF
+
+        if offset >= len(self.strings):
+            return None
+
+        end = self.strings.find(b'\x00', offset)
+
+        return self.strings[offset:end].decode('latin-1')
+
+    def read_string(self, addr: int) -> str:
+        """ Read a NUL terminated string from the ELF file, as the target has
+        it in ROM """
+        data = bytearray()
+
+        while len(data) < MAX_STRING:
+            chunk = self.elf.read(addr + len(data), 1)
+
+            if chunk is None or chunk == b'\x00':
+                break
+
+            data += chunk
+
+        if chunk is None and len(data) == 0:
+            return f'<0x{addr:08X}>'
+
+        return data.decode('latin-1')
+
+    def render(self, fmt: str, args: list) -> str:
+        args = list(args)
+
+        def convert(m):
+            flags, width, precision, length, conv = m.groups()
+
+            if conv == '%':
+                return '%'
+
+            if width == '*':
+                width = str(_signed(args.pop(0), 32)) if args else ''
+
+            if not args:
+                return m.group(0)
+
+            val = args.pop(0)
+            spec = '%' + flags + width
+
+            if precision is not None:
+                spec += '.' + precision
+
+            bits = {'hh': 8, 'h': 16}.get(length, 32)
+
+            if conv in 'di':
+                return (spec + 'd') % _signed(val, bits)
+
+            if conv in 'ouxX':
+                return (spec + conv) % (val & ((1 << bits) - 1))
+
+            if conv == 'c':
+                return (spec + 'c') % chr(val & 0xFF)
+
+            if conv == 'p':
+                return (spec + 's') % f'0x{val:08X}'
+
+            return (spec + 's') % self.read_string(val)
+
+        return SPEC_RE.sub(convert, fmt)
+
+    def decode(self, record: bytes) -> str:
+        nargs = record[1]
+        id = (record[2] << 8) | record[3]
+        timestamp = int.from_bytes(record[4:8], 'big')
+        args = [
+            int.from_bytes(record[8 + i * 4:12 + i * 4], 'big')
+            for i in range(nargs)
+        ]
+
+        if id == LOG_ID_DROPPED:
+            text = f'*** {args[0]} log records dropped ***'
+        else:
+            fmt = self.format_string(id)
+
+            if fmt is None:
+                text = f'<unknown format 0x{id:04X}> ' + \
+                    ' '.join(f'0x{a:08X}' for a in args)
+            else:
+                text = self.render(fmt, args).rstrip('\r\n')
+
+        return f'[{timestamp:10}] {text}'
+
+    def feed(self, data: bytes) -> str:
+        """ Take bytes received from the target, returning the text to be
+        shown """
+        self.buf += data
+        out = []
+
+        while len(self.buf) > 0:
+            if self.buf[0] != LOG_SYNC:
+                char = self.buf.pop(0)
+
+                # Printable text is passed through, CR starting a new line
+                if char == 0x0D:
+                    out.append('\n')
+                    self.column = 0
+                elif 0x20 <= char < 0x7F:
+                    out.append(chr(char))
+                    self.column += 1
+
+                continue
+
+            if len(self.buf) < 2:
+                break
+
+            nargs = self.buf[1]
+            length = LOG_HEADER_LEN + nargs * 4 + 1
+
+            if nargs > LOG_MAX_ARGS or (len(self.buf) >= length and
+                                        sum(self.buf[1:length]) & 0xFF != 0):
+                # Not a valid record, so skip the sync byte and carry on
+                self.errors += 1
+                self.buf.pop(0)
+
+                continue
+
+            if len(self.buf) < length:
+                break
+
+            if self.column > 0:
+                out.append('\n')
+
+            out.append(self.decode(bytes(self.buf[:length])) + '\n')
+            self.column = 0
+            self.records += 1
+
+            del self.buf[:length]
+
+        return ''.join(out)
+
+
+def _signed(val: int, bits: int) -> int:
+    val &= (1 << bits) - 1
+
+    return val - (1 << bits) if val & (1 << (bits - 1)) else val
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decode binary log records sent by a program using LOG()'
+    )
+    parser.add_argument(
+        'elf',
+        type=str,
+        help='ELF file of the program running on the target'
+    )
+    parser.add_argument(
+        '-p', '--port',
+        dest='port', type=str, default=DEV,
+        help=f'Serial device (default {DEV})'
+    )
+    parser.add_argument(
+        '--baud',
+        dest='baud', type=int, default=BAUD,
+        help=f'Baud rate (default {BAUD})'
+    )
+    parser.add_argument(
+        '-i', '--input',
+        dest='input', type=str, default=None,
+        help='Decode a file of previously captured data rather than reading '
+             'the serial port'
+    )
+    args = parser.parse_args()
+
+    decoder = LogDecoder(args.elf)
+
+    if args.input is not None:
+        with open(args.input, 'rb') as f:
+            print(decoder.feed(f.read()), end='')
+    else:
+        from serial import Serial
+
+        ser = Serial(args.port, baudrate=args.baud, timeout=0.1)
+
+        try:
+            while True:
+                data = ser.read(size=max(1, ser.in_waiting))
+                print(decoder.feed(data), end='', flush=True)
+        except KeyboardInterrupt:
+            pass
+
+        ser.close()
+
+    if decoder.errors:
+        print(f'\n{decoder.errors} bytes skipped while searching for records',
+              file=sys.stderr)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,239 @@
+# LZ4 block format compression, for compressed ROM images
+#
+# Compressed data is a series of sequences, each a token byte, a run of
+# literal bytes, and a match: a 16 bit little endian offset back into the output
+# from which to repeat at least 4 bytes. The high nibble of the token is the
+# number of literals, and the low nibble the match length less 4. A nibble of 15
+# is followed by further length bytes, which are added on until one that is not
+# 255. The last sequence has literals only.
+#
+# This format was chosen because it can be decoded a byte at a time without any
+# bit shuffling, which suits the 68000. The decompressor is in crt0.S.
+#
+# The compressor follows the same rules as the reference implementation (the
+# last 5 bytes are always literals, and no match starts within the last 12),
+# so its output can also be checked with standard LZ4 tools.
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+LAST_LITERALS = 5
+MATCH_LIMIT = 12
+
+HASH_BITS = 16
+MAX_CHAIN = 64
+
+# Cycles taken by the decompressor in crt0.S, from the 68000 instruction
+# timings, and the number of bus accesses to ROM made along the way. Each is
+# (cycles, ROM accesses).
+CYCLES_SEQUENCE = (76, 14)        # Token, and checking for the end
+CYCLES_LITERALS = (60, 8)         # Setting up a run of literals
+CYCLES_LITERAL = (22, 4)          # Each literal byte
+CYCLES_MATCH = (130, 22)          # Offset and setting up a match
+CYCLES_MATCH_BYTE = (22, 3)       # Each byte of a match
+CYCLES_LENGTH = (38, 6)           # Each extra length byte
+
+
+class LZ4Error(Exception):
+    pass
+
+
+def _hash(data: bytes, pos: int) -> int:
+    val = int.from_bytes(data[pos:pos + 4], 'little')
+
+    return ((val * 2654435761) & 0xFFFFFFFF) >> (32 - HASH_BITS)
+
+
+def _length(out: bytearray, length: int):
+    """ Append the extra length bytes for a nibble of 15 """
+    length -= 15
+
+    while length >= 255:
+        out.append(255)
+        length -= 255
+
+    out.append(length)
+
+
+def _sequence(out: bytearray, literals: bytes, offset: int, match: int):
+    lit_nibble = min(len(literals), 15)
+    match_nibble = min(match - MIN_MATCH, 15) if match else 0
+
+    out.append((lit_nibble << 4) | match_nibble)
+
+    if lit_nibble == 15:
+        _length(out, len(literals))
+
+    out += literals
+
+    if match:
+        out += offset.to_bytes(2, 'little')
+
+        if match_nibble == 15:
+            _length(out, match - MIN_MATCH)
+
+
+def compress(data: bytes) -> bytes:
+    """ Compress data, greedily taking the longest match found with a hash
+    chain, but deferring it by a byte if a longer match starts there """
+    out = bytearray()
+    head = {}
+    prev = [-1] * len(data)
+    limit = len(data) - MATCH_LIMIT
+    end = len(data) - LAST_LITERALS
+    inserted = 0
+    anchor = 0
+    pos = 0
+
+    def find(p):
+        nonlocal inserted
+
+        # Add every position before p to the hash chains
+        while inserted < p:
+            h = _hash(data, inserted)
+            prev[inserted] = head.get(h, -1)
+            head[h] = inserted
+            inserted += 1
+
+        best_len = 0
+        best_off = 0
+        cand = head.get(_hash(data, p), -1)
+        chain = MAX_CHAIN
+
+        while cand >= 0 and p - cand <= MAX_OFFSET and chain > 0:
+            if data[cand + best_len] == data[p + best_len]:
+                n = 0
+
+                while p + n < end and data[cand + n] == data[p + n]:
+                    n += 1
+
+                if n > best_len:
+                    best_len = n
+                    best_off = p - cand
+
+            cand = prev[cand]
+            chain -= 1
+
+        return (best_len, best_off) if best_len >= MIN_MATCH else (0, 0)
+
+    while pos < limit:
+        length, offset = find(pos)
+
+        if length == 0:
+            pos += 1
+
+            continue
+
+        # Lazy matching: one byte on might give a longer match
+        if pos + 1 < limit:
+            next_len, next_off = find(pos + 1)
+
+            if next_len > length:
+                pos += 1
+                length, offset = next_len, next_off
+
+        _sequence(out, data[anchor:pos], offset, length)
+
+        pos += length
+        anchor = pos
+
+    _sequence(out, data[anchor:], 0, 0)
+
+    return bytes(out)
+
+
+def _read_length(data: bytes, pos: int, length: int) -> tuple:
+    while True:
+        if pos >= len(data):
+            raise LZ4Error('Compressed data is truncated')
+
+        byte = data[pos]
+        pos += 1
+        length += byte
+
+        if byte != 255:
+            return length, pos
+
+
+def decompress(data: bytes) -> bytes:
+    out = bytearray()
+    pos = 0
+
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+
+        length = token >> 4
+
+        if length == 15:
+            length, pos = _read_length(data, pos, length)
+
+        out += data[pos:pos + length]
+        pos += length
+
+        if pos >= len(data):
+            break
+
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+
+        if offset == 0 or offset > len(out):
+            raise LZ4Error(f'Bad match offset {offset}')
+
+        length = token & 15
+
+        if length == 15:
+            length, pos = _read_length(data, pos, length)
+
+        length += MIN_MATCH
+        start = len(out) - offset
+
+        for i in range(length):
+            out.append(out[start + i])
+
+    return bytes(out)
+
+
+def decode_cycles(data: bytes, rom_wait: int) -> int:
+    """ Estimate the cycles taken to decompress data with the decompressor in
+    crt0.S, which runs from ROM, adding rom_wait cycles to each ROM access """
+    total = 0
+    pos = 0
+
+    def add(cost, count=1):
+        nonlocal total
+        total += count * (cost[0] + cost[1] * rom_wait)
+
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        add(CYCLES_SEQUENCE)
+
+        length = token >> 4
+
+        if length:
+            add(CYCLES_LITERALS)
+
+            if length == 15:
+                start = pos
+                length, pos = _read_length(data, pos, length)
+                add(CYCLES_LENGTH, pos - start)
+
+            add(CYCLES_LITERAL, length)
+            pos += length
+
+        if pos >= len(data):
+            break
+
+        pos += 2
+        add(CYCLES_MATCH)
+
+        length = token & 15
+
+        if length == 15:
+            start = pos
+            length, pos = _read_length(data, pos, length)
+            add(CYCLES_LENGTH, pos - start)
+
+        add(CYCLES_MATCH_BYTE, length + MIN_MATCH)
+
+    return total
@@ -2,6 +2,21 @@
 #include <stdint.h>
 #include "TL16C2552.h"
 
+#ifndef SIM_HOST
+#include "bootprof.h"
+#endif /* SIM_HOST */
+
+/* Target memory accessors. On the target these are plain dereferences. The
+ * host simulator (see sim/) supplies its own versions to map target addresses
+ * on to its memory model. */
+#ifndef MEM_PTR
+#define MEM_PTR(addr) ((uint8_t *)(addr))
+#define MEM_RD16(ptr) (*(ptr))
+#define MEM_RD32(ptr) (*(ptr))
+#define MEM_WR16(ptr, val) (*(ptr) = (val))
+#define MEM_WR32(ptr, val) (*(ptr) = (val))
+#endif
+
 typedef enum {
     STATE_DEFAULT = 0,
     STATE_PING,
@@ -33,16 +48,23 @@ enum {
 void
 init_uart(void)
 {
-    /* Configure UART channel A */
-    UALCRbits.WLEN = 3;             /* 8 bits per byte */
-    UALCRbits.SLEN = 0;             /* 1 stop bit */
-    UALCRbits.PEN = 0;              /* Parity is disabled */
+    /* Configure UART channel A. The line control register is built up here
+     * and written whole, as each write to a bitfield of the register itself
+     * is a read and a write on the X-bus. */
+    __UARTLCRbits_t lcr = { .u8 = 0 };
+
+    lcr.WLEN = 3;                   /* 8 bits per byte */
+    lcr.SLEN = 0;                   /* 1 stop bit */
+    lcr.PEN = 0;                    /* Parity is disabled */
 
-    UALCRbits.DLAB = 1;             /* Access the divisor registers */
+    lcr.DLAB = 1;                   /* Access the divisor registers */
+    UALCR = lcr.u8;
     UADLL = 2;                      /* Divide input freq for 230400 baud at
                                      * 7.3728MHz */
     UADLM = 0;
-    UALCRbits.DLAB = 0;
+
+    lcr.DLAB = 0;
+    UALCR = lcr.u8;
 
     UAFCR = 0x7;                    /* Reset FIFOs and enable tx and rx */
 }
@@ -109,6 +131,11 @@ main(void)
 {
     init_uart();
 
+#if defined(BOOT_PROFILE) && !defined(SIM_HOST)
+    /* Start up is complete. bootprof.py reads the profile from here. */
+    bootprof_mark(BOOTPROF_READY);
+#endif /* BOOT_PROFILE && !SIM_HOST */
+
     uint32_t data_len = 0;
     uint32_t addr = 0;
     uint8_t *data_ptr;
@@ -145,7 +172,7 @@ main(void)
                 data_len = uart_get_long();
 
                 /* Next get the address where the data is to be loaded */
-                data_ptr = (uint8_t *)uart_get_long();
+                data_ptr = MEM_PTR(uart_get_long());
 
                 /* Now receive further bytes until code_len is decremented to
                  * zero */
@@ -173,6 +200,13 @@ main(void)
                  * host has received the response */
                 while (UALSRbits.TXIDL == 0);
 
+#ifdef SIM_HOST
+                /* The simulator cannot run 68000 code, so it just reports the
+                 * transfer of control */
+                sim_execute(addr, state == STATE_JUMP);
+
+                state = STATE_DEFAULT;
+#else
                 if (state == STATE_EXECUTE) {
                     asm volatile(
                         /* Put addr into A0 then jump to subroutine. Reset
@@ -202,6 +236,7 @@ main(void)
                         :
                     );
                 }
+#endif /* SIM_HOST */
 
                 break;
 
@@ -220,7 +255,7 @@ main(void)
                 data_len = uart_get_long();
 
                 /* Next get the address where the data is to be read from */
-                data_ptr = (uint8_t *)uart_get_long();
+                data_ptr = MEM_PTR(uart_get_long());
                 data_ptr16 = (uint16_t *)data_ptr;
                 data_ptr32 = (uint32_t *)data_ptr;
 
@@ -246,12 +281,12 @@ main(void)
                         if (data_type == 0x01) {
                             UATHR = *data_ptr++;
                         } else if (data_type == 0x02) {
-                            word_data = *data_ptr16++;
+                            word_data = MEM_RD16(data_ptr16++);
 
                             UATHR = (word_data >> 8);
                             UATHR = word_data;
                         } else if (data_type == 0x04) {
-                            long_data = *data_ptr32++;
+                            long_data = MEM_RD32(data_ptr32++);
 
                             UATHR = (long_data >> 24);
                             UATHR = (long_data >> 16);
@@ -281,7 +316,7 @@ main(void)
                 data_len = uart_get_long();
 
                 /* Next get the address where the data is to be loaded */
-                data_ptr = (uint8_t *)uart_get_long();
+                data_ptr = MEM_PTR(uart_get_long());
                 data_ptr16 = (uint16_t *)data_ptr;
                 data_ptr32 = (uint32_t *)data_ptr;
 
@@ -290,9 +325,9 @@ main(void)
                     if (data_type == 0x01) {
                         *data_ptr++ = uart_get_char();
                     } else if (data_type == 0x02) {
-                        *data_ptr16++ = uart_get_word();
+                        MEM_WR16(data_ptr16++, uart_get_word());
                     } else if (data_type == 0x04) {
-                        *data_ptr32++ = uart_get_long();
+                        MEM_WR32(data_ptr32++, uart_get_long());
                     }
                 }
 
@@ -318,7 +353,7 @@ main(void)
                 data_len = uart_get_long();
 
                 /* Next get the address where the data is to be read from */
-                data_ptr = (uint8_t *)uart_get_long();
+                data_ptr = MEM_PTR(uart_get_long());
                 data_ptr16 = (uint16_t *)data_ptr;
                 data_ptr32 = (uint32_t *)data_ptr;
 
@@ -344,12 +379,12 @@ main(void)
                         if (data_type == 0x01) {
                             UATHR = *data_ptr;
                         } else if (data_type == 0x02) {
-                            word_data = *data_ptr16;
+                            word_data = MEM_RD16(data_ptr16);
 
                             UATHR = (word_data >> 8);
                             UATHR = word_data;
                         } else if (data_type == 0x04) {
-                            long_data = *data_ptr32;
+                            long_data = MEM_RD32(data_ptr32);
 
                             UATHR = (long_data >> 24);
                             UATHR = (long_data >> 16);
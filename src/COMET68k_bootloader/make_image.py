@@ -1,40 +1,235 @@
-# Create a combined, checksummed ROM-devicetree image ready for programming
+# Create a partitioned, checksummed ROM-devicetree image ready for programming
 #
-# The layout of the image will look as follows:
+# The image is divided into partitions, which are listed in a table at the very
+# end of the image (see parttable.py for its layout):
 #
-# Highest address: checksum (long)
-#                  8KB - 4 bytes (devicetree area)
+# Highest address: partition table (512 bytes)
+#                  devicetree blob (8KB - 512 bytes)
+#                  further partitions (applications, filesystems, data)
 #                  (blank space filled with all ones)
-#  Lowest address: n bytes (application code)
+#  Lowest address: n bytes (bootloader, or application code)
 #
 # The size of the devicetree area defaults to the highest 8KB of the image, but
 # the size may be adjusted with the dtsz commandline option. The size must be
 # specified as a multiple of 2KB and must be a minimum of 8KB.
 #
-# The checksum is a long value which, when added to the sum of all prior long
-# values, results in a final value of 0.
-
+# Each partition is given a whole number of 4KB sectors, and has a CRC32 of its
+# contents in the table. Further partitions are added with the part option, e.g.
+# -p app:monitor=monitor.bin@0x1000, and are placed below the devicetree from
+# the top down, leaving the space above the bootloader free for it to grow.
+#
+# If the output image already exists, it is updated rather than rebuilt:
+# partitions whose input has not changed are left exactly as they are, and
+# those that have changed are rewritten in place if they still fit, or moved if
+# not. Only the sectors that differ then need to be reprogrammed. The changes
+# option writes just those sectors to an S-record file, for device programmers
+# that can program part of a device. Space that a partition moves out of is left
+# as it was. Use the fresh option to lay the image out from scratch, with all
+# unused space blank.
+#
+# The devicetree blob is followed by an index of its nodes, which libfdt's
+# fdt_index.h uses to find nodes without walking the blob (see fdtindex.py),
+# unless the noindex option is given or there is not room for it.
+#
+# A romfs partition may be given a directory rather than a file, in which case a
+# read only filesystem image is built from it (see romfs.py). An image for ROM0,
+# which holds no bootloader or devicetree, is made by leaving out the input and
+# blob options, e.g.:
+#
+#   python3 make_image.py -p romfs:assets=assets/ -o rom0.bin
+#
+import os
+import sys
 import struct
 import argparse
 
+from lz4block import compress, decompress, decode_cycles
+from romfs import RomfsError, read_dir, build as build_romfs
+from fdtindex import FdtError, append as append_index
+from parttable import (Partition, PartError, TYPES, FLAG_EXEC, FLAG_COMPRESSED,
+                       TABLE_SIZE, SECTOR_SIZE, crc32, sectors, pack_table,
+                       read_table, type_name)
+
 DEFAULT_DEVTREE_SIZE = 8
 DEFAULT_ROM_SIZE = 512
 
+# The compressed image header follows the exception vector table
+HEADER_OFFSET = 0x400
+HEADER_FORMAT = ">4sLLLL"
+HEADER_MAGIC = b"COMZ"
+
+# For estimating the decompression time. The CPLD adds roughly one wait state to
+# each ROM access (xbus_machine, ROM_WAIT_STATES at 40MHz).
+CPU_CLOCK = 10000000
+ROM_WAIT = 1
+
+def compress_payload(input_bin: bytes) -> bytes:
+    """ Compress the payload of an application binary linked with
+    platform_z.ld, returning the new binary or None on error """
+    header_size = struct.calcsize(HEADER_FORMAT)
+    header = input_bin[HEADER_OFFSET:HEADER_OFFSET + header_size]
+
+    if len(header) < header_size or header[:4] != HEADER_MAGIC:
+        print("Input application binary has no compressed image header (link with platform_z.ld)")
+
+        return None
+
+    magic, offset, addr, size, csize = struct.unpack(HEADER_FORMAT, header)
+
+    if csize != 0xFFFFFFFF:
+        print("Input application binary is already compressed")
+
+        return None
+
+    if offset + size != len(input_bin):
+        print("Input application binary does not end with the payload")
+
+        return None
+
+    payload = input_bin[offset:]
+
+    print(f"Compressing {size} bytes of code and data at {addr:08X} ... ", end="")
+
+    packed = compress(payload)
+
+    if decompress(packed) != payload:
+        print("FAILED")
+
+        return None
+
+    print(f"{len(packed)} bytes ({len(packed) * 100 / size:.1f}%)")
+
+    cycles = decode_cycles(packed, ROM_WAIT)
+
+    print(f"Estimated decompression time at {CPU_CLOCK // 1000000}MHz: "
+          f"{cycles * 1000 / CPU_CLOCK:.1f}ms ({cycles} cycles)")
+
+    header = struct.pack(HEADER_FORMAT, magic, offset, addr, size, len(packed))
+
+    output_bin = input_bin[:HEADER_OFFSET] + header + \
+                 input_bin[HEADER_OFFSET + header_size:offset] + packed
+
+    print(f"Application binary reduced from {len(input_bin)} to {len(output_bin)} bytes")
+
+    return output_bin
+
+def parse_part(spec: str) -> Partition:
+    """ Read the partition given by a part option, TYPE:NAME=FILE[@LOAD] """
+    try:
+        part_type, rest = spec.split(":", 1)
+        name, filename = rest.split("=", 1)
+    except ValueError:
+        raise PartError(f"Partition {spec} should be given as TYPE:NAME=FILE[@LOAD]")
+
+    if part_type not in TYPES or part_type in ("boot", "dtb"):
+        raise PartError(f"Partition {name} has an invalid type {part_type}")
+
+    load = 0
+    flags = 0
+
+    if "@" in filename:
+        filename, load = filename.rsplit("@", 1)
+        load = int(load, 0)
+        flags |= FLAG_EXEC
+
+    if part_type == "romfs" and os.path.isdir(filename):
+        data = build_romfs(read_dir(filename))
+    else:
+        with open(filename, "rb") as f:
+            data = f.read()
+
+    return Partition(name, TYPES[part_type], data, load=load, flags=flags, src_crc=crc32(data))
+
+def layout(parts: list, old_parts: list, rom_size_bytes: int) -> None:
+    """ Give each partition an offset and size. The bootloader and devicetree
+    have fixed places. Others keep their place from the previous image if they
+    still fit there, and otherwise take the highest free space that they fit
+    in. """
+    placed = []
+
+    def free(offset: int, size: int) -> bool:
+        return all(offset + size <= p.offset or p.offset + p.size <= offset for p in placed)
+
+    for p in parts:
+        if p.offset is not None:
+            placed.append(p)
+
+    old = {(p.name, p.type): p for p in old_parts}
+
+    for p in parts:
+        if p.offset is not None:
+            continue
+
+        prev = old.get((p.name, p.type))
+
+        if prev is not None and p.length <= prev.size and free(prev.offset, prev.size):
+            p.offset = prev.offset
+            p.size = prev.size
+            placed.append(p)
+
+    # Below the partition table, which shares its sector with the devicetree
+    top = (rom_size_bytes - TABLE_SIZE) & ~(SECTOR_SIZE - 1)
+
+    for p in parts:
+        if p.offset is not None:
+            continue
+
+        p.size = max(sectors(p.length), SECTOR_SIZE)
+        offset = top - p.size
+
+        while offset >= 0 and not free(offset, p.size):
+            offset -= SECTOR_SIZE
+
+        if offset < 0:
+            raise PartError(f"No room in the image for partition {p.name} ({p.length} bytes)")
+
+        p.offset = offset
+        placed.append(p)
+
+def write_srec(filename: str, segments: list) -> None:
+    """ Write (offset, data) segments as S3 records """
+    def record(rec_type: str, addr: int, data: bytes) -> str:
+        raw = bytes([len(data) + 5]) + struct.pack(">L", addr) + data
+        return f"S{rec_type}{raw.hex().upper()}{(~sum(raw)) & 0xFF:02X}\n"
+
+    with open(filename, "w") as f:
+        f.write(record("0", 0, b"make_image"))
+
+        for offset, data in segments:
+            for pos in range(0, len(data), 32):
+                f.write(record("3", offset + pos, data[pos:pos + 32]))
+
+        f.write(record("7", 0, b""))
+
 def main() -> None:
     # Parse command line options
-    parser = argparse.ArgumentParser(description="Create a combined, checksummed ROM-devicetree "
+    parser = argparse.ArgumentParser(description="Create a partitioned, checksummed ROM-devicetree "
                                                  "image ready for programming")
     parser.add_argument("-d", "--dtsz", dest="devtree_size", default=DEFAULT_DEVTREE_SIZE, type=int,
                         help= "The number of kilobytes to set aside at the top of the resulting "
                              f"image for the devicetree blob (default {DEFAULT_DEVTREE_SIZE})")
     parser.add_argument("-s", "--romsz", dest="rom_size", default=DEFAULT_ROM_SIZE, type=int,
                         help=f"The size of the resulting image in kilobytes (default {DEFAULT_ROM_SIZE})")
-    parser.add_argument("-i", "--input", dest="input_bin", required=True, help="Filename of input application binary")
-    parser.add_argument("-b", "--blob", dest="input_blob", required=True, help="Filename of input devicetree blob")
+    parser.add_argument("-i", "--input", dest="input_bin", default=None,
+                        help="Filename of input application binary (left out for an image without one, e.g. for ROM0)")
+    parser.add_argument("-b", "--blob", dest="input_blob", default=None,
+                        help="Filename of input devicetree blob (left out for an image without one)")
     parser.add_argument("-o", "--output", dest="output_img", required=True, help="Filename of output programming image")
+    parser.add_argument("-n", "--noindex", dest="no_index", action="store_true",
+                        help="Do not add an index of the devicetree after the blob")
+    parser.add_argument("-z", "--compress", dest="compress", action="store_true",
+                        help="Compress the code and data of an application binary linked with platform_z.ld")
+    parser.add_argument("-p", "--part", dest="parts", action="append", default=[],
+                        help="Add a partition, given as TYPE:NAME=FILE[@LOAD], where TYPE is one of "
+                             "app, romfs or data, and LOAD is the address it runs from. FILE may be a "
+                             "directory for a romfs partition")
+    parser.add_argument("-f", "--fresh", dest="fresh", action="store_true",
+                        help="Lay out the image from scratch, rather than updating an existing one")
+    parser.add_argument("-c", "--changes", dest="changes", default=None,
+                        help="Write the sectors that differ from the existing image to this S-record file")
     args = parser.parse_args()
 
-    dtb_size_bytes = (args.devtree_size * 1024) - 4
+    dtb_size_bytes = (args.devtree_size * 1024) - TABLE_SIZE
     rom_size_bytes = args.rom_size * 1024
 
     # Sanity check arguments
@@ -43,93 +238,169 @@ def main() -> None:
 
         return 1
 
-    # Load input files
-    input_bin = None
-    input_blob = None
+    # Read the existing image, if there is one, so that only what has changed
+    # needs to be rebuilt
+    old_img = None
+    old_parts = []
 
-    print("Reading input application binary ...")
-    with open(args.input_bin, "rb") as f:
-        input_bin = f.read()
+    if not args.fresh and os.path.exists(args.output_img):
+        with open(args.output_img, "rb") as f:
+            old_img = f.read()
 
-    print("Reading input devicetree blob ...")
-    with open(args.input_blob, "rb") as f:
-        input_blob = f.read()
-    
-    # Make sure sizes are workable
-    if len(input_bin) > (rom_size_bytes - (dtb_size_bytes + 4)):
-        print("Input application binary is too big to fit")
+        if len(old_img) != rom_size_bytes:
+            old_img = None
+        else:
+            old_parts = read_table(old_img) or []
+            print(f"Updating existing image ({len(old_parts)} partitions)")
 
-        return 1
-    
-    if len(input_blob) > dtb_size_bytes:
-        print("Input devicetree blob is too big to fit")
+    old = {(p.name, p.type): p for p in old_parts}
 
-        return 1
+    parts = []
+
+    # Load input files. The bootloader must be at the start of the image, where
+    # the vector table is, and the devicetree at the top where it has always
+    # been.
+    if args.input_bin is not None:
+        print("Reading input application binary ...")
+        with open(args.input_bin, "rb") as f:
+            input_bin = f.read()
+
+        flags = 0
+        src_crc = crc32(input_bin)
+        prev = old.get(("boot", TYPES["boot"]))
 
-    with open(args.output_img, "w+b") as f:
-        print("Writing combined image file ...")
+        if args.compress:
+            flags |= FLAG_COMPRESSED
 
-        # First write in the application binary
-        f.seek(0)
-        f.write(input_bin)
+            if prev is not None and prev.src_crc == src_crc and prev.flags == flags:
+                # Compressing takes a while, and gives the same result each time
+                print("Input application binary is unchanged, keeping its compressed form")
+                input_bin = prev.data
+            else:
+                input_bin = compress_payload(input_bin)
 
-        # Then write in filler space before the devicetree blob
-        filler_bytes = rom_size_bytes - len(input_bin) - dtb_size_bytes - 4
-        f.write(bytes([0xFF] * filler_bytes))
+            if input_bin is None:
+                return 1
 
-        # Then write in the devicetree blob
-        f.write(input_blob)
+        if len(input_bin) > (rom_size_bytes - (dtb_size_bytes + TABLE_SIZE)):
+            print("Input application binary is too big to fit")
 
-        # Then write in filler space before the checksum
-        filler_bytes = dtb_size_bytes - len(input_blob)
-        f.write(bytes([0xFF] * filler_bytes))
+            return 1
 
-        # Now calculate the checksum value
-        print("Calculating checksum ... ", end="")
+        parts.append(Partition("boot", TYPES["boot"], input_bin, flags=flags,
+                               src_crc=src_crc, offset=0, size=sectors(len(input_bin))))
 
-        iters = int((rom_size_bytes / 4) - 1)
-        cksum = 0
+    if args.input_blob is not None:
+        print("Reading input devicetree blob ...")
+        with open(args.input_blob, "rb") as f:
+            input_blob = f.read()
 
-        f.seek(0)
+        if len(input_blob) > dtb_size_bytes:
+            print("Input devicetree blob is too big to fit")
 
-        while iters > 0:
-            l = struct.unpack(">L", f.read(4))[0]
+            return 1
 
-            cksum -= l
-            cksum &= 0xFFFFFFFF
-            
-            iters -= 1
+        src_crc = crc32(input_blob)
 
-        # Write checksum to end of file
-        f.write(struct.pack(">L", cksum))
+        if not args.no_index:
+            try:
+                indexed = append_index(input_blob)
+            except FdtError as e:
+                print(e)
 
-        print(f"{cksum:08X}")
+                return 1
 
-        # Verify the checksum
-        print("Verifying checksum ... ", end="")
+            if len(indexed) > dtb_size_bytes:
+                print("No room for the devicetree index, leaving it out")
+            else:
+                print(f"Devicetree index added ({len(indexed) - len(input_blob)} bytes)")
+                input_blob = indexed
 
-        iters = int(rom_size_bytes / 4)
-        total = 0
+        parts.append(Partition("dtb", TYPES["dtb"], input_blob, src_crc=src_crc,
+                               offset=rom_size_bytes - dtb_size_bytes - TABLE_SIZE,
+                               size=dtb_size_bytes))
 
-        f.seek(0)
+    try:
+        for spec in args.parts:
+            parts.append(parse_part(spec))
 
-        while iters > 0:
-            l = struct.unpack(">L", f.read(4))[0]
+        if len(set(p.name for p in parts)) != len(parts):
+            raise PartError("Partition names must be unique")
 
-            total += l
-            total &= 0xFFFFFFFF
-            
-            iters -= 1
+        layout(parts, old_parts, rom_size_bytes)
+        table = pack_table(parts, rom_size_bytes)
+    except (PartError, RomfsError, OSError, ValueError) as e:
+        print(e)
 
-        # Print result of checksum sequence
-        if total == 0:
-            print("OK")
-            print("Image file is ready for programming")
+        return 1
+
+    print("Writing partitioned image file ...")
+
+    # Space no longer used by any partition is left as it was, rather than
+    # being erased, so that it does not need reprogramming
+    img = bytearray(old_img if old_img is not None else [0xFF] * rom_size_bytes)
+
+    for p in parts:
+        img[p.offset:p.offset + p.length] = p.data
+
+        # The rest of the devicetree's space is erased, so that the index of an
+        # earlier blob cannot be left after one that has none (with noindex, or
+        # when there is no room). It would still be found, and trusted, if the
+        # new blob happened to be the same size.
+        if p.type == TYPES["dtb"]:
+            img[p.offset + p.length:p.offset + p.size] = bytes([0xFF]) * (p.size - p.length)
+
+    img[-TABLE_SIZE:] = table
+
+    with open(args.output_img, "wb") as f:
+        f.write(img)
+
+    # Report what has changed since the previous image, a sector at a time, as
+    # that is how the ROM is erased and programmed
+    changed = []
+
+    for offset in range(0, rom_size_bytes, SECTOR_SIZE):
+        if old_img is None or old_img[offset:offset + SECTOR_SIZE] != img[offset:offset + SECTOR_SIZE]:
+            changed.append(offset)
+
+    for p in parts:
+        prev = old.get((p.name, p.type))
+
+        if prev is None:
+            status = "new"
+        elif prev.offset != p.offset:
+            status = "moved"
+        elif prev.crc != p.crc or prev.length != p.length:
+            status = "changed"
         else:
-            print(f"BAD ({total:08X})")
-            print("Image file is invalid")
+            status = "unchanged"
+
+        print(f"  {p.name:8} {type_name(p.type):5} {p.offset:06X}-{p.offset + p.size - 1:06X} "
+              f"{p.length:7} bytes  CRC32 {p.crc:08X}  {status}")
+
+    print(f"{len(changed)} of {rom_size_bytes // SECTOR_SIZE} sectors to be programmed")
+
+    if args.changes is not None:
+        segments = [(offset, bytes(img[offset:offset + SECTOR_SIZE])) for offset in changed]
+        write_srec(args.changes, segments)
+        print(f"Changed sectors written to {args.changes}")
 
+    # Verify the partitions as read back from the file
+    print("Verifying partitions ... ", end="")
+
+    with open(args.output_img, "rb") as f:
+        check = read_table(f.read())
+
+    if check is not None and all(crc32(p.data) == p.crc for p in check):
+        print("OK")
+        print("Image file is ready for programming")
+    else:
+        print("BAD")
+        print("Image file is invalid")
+
+        return 1
 
+    return 0
 
 if __name__ == "__main__":
-    main()
+    sys.exit(main())
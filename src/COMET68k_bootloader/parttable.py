@@ -0,0 +1,196 @@
+# Partition table for ROM images
+#
+# A ROM image made by make_image.py is divided into partitions: the bootloader,
+# applications, the devicetree blob, read only filesystems and so on. A table at
+# the very end of the image says where each one is, so that the target can find
+# and check just the partitions it needs, and so that make_image.py can rebuild
+# and reprogram just the partitions that have changed.
+#
+# Table layout (the last TABLE_SIZE bytes of the image, see libcomet/part.h):
+#
+#   header: magic "CPT1", version (16 bits), entry count (16 bits), image size,
+#           CRC32 of the entries
+#   entries: name (8 bytes, padded with zeros), type (8 bits), flags (8 bits),
+#            reserved (16 bits), offset in image, space allotted, length used,
+#            load address, CRC32 of the contents, CRC32 of the input the
+#            contents were built from, reserved
+#
+# All values are most significant byte first. The CRC32 is the common one
+# (as zlib.crc32, or the one used by Ethernet).
+#
+# Run on its own, this lists the partitions of an image and checks them:
+#
+#   python3 parttable.py bootloader.bin
+
+import argparse
+import struct
+import sys
+import zlib
+
+TABLE_SIZE = 0x200
+TABLE_MAGIC = b'CPT1'
+TABLE_VERSION = 1
+HEADER_FORMAT = '>4sHHLL'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+ENTRY_FORMAT = '>8sBBHLLLLLLL'
+ENTRY_SIZE = struct.calcsize(ENTRY_FORMAT)
+MAX_PARTS = (TABLE_SIZE - HEADER_SIZE) // ENTRY_SIZE
+
+# The 39SF040 is erased a 4KB sector at a time, so partitions are allotted
+# whole sectors, and a change to one never needs another to be reprogrammed
+SECTOR_SIZE = 0x1000
+
+TYPES = {
+    'boot': 1,                      # Bootloader, at the start of the image
+    'app': 2,                       # Application
+    'dtb': 3,                       # Devicetree blob
+    'romfs': 4,                     # Read only filesystem
+    'data': 5,                      # Anything else
+}
+
+FLAG_EXEC = 0x01                    # Load address is where to run it from
+FLAG_COMPRESSED = 0x02              # Contents are compressed (see lz4block.py)
+
+
+class PartError(Exception):
+    pass
+
+
+def type_name(part_type: int) -> str:
+    for name, val in TYPES.items():
+        if val == part_type:
+            return name
+
+    return str(part_type)
+
+
+def crc32(data: bytes) -> int:
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def sectors(size: int) -> int:
+    """ Round size up to a whole number of sectors """
+    return (size + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1)
+
+
+class Partition:
+    def __init__(self, name: str, part_type: int, data: bytes = b'',
+                 load: int = 0, flags: int = 0, src_crc: int = 0,
+                 offset: int = None, size: int = 0, crc: int = None):
+        if len(name.encode()) > 8:
+            raise PartError(f'Partition name {name} is longer than 8 bytes')
+
+        self.name = name
+        self.type = part_type
+        self.data = data
+        self.load = load
+        self.flags = flags
+        self.src_crc = src_crc
+        self.offset = offset
+        self.size = size
+        self.length = len(data)
+        self.crc = crc32(data) if crc is None else crc
+
+    def pack(self) -> bytes:
+        return struct.pack(
+            ENTRY_FORMAT, self.name.encode(), self.type, self.flags, 0,
+            self.offset, self.size, self.length, self.load, self.crc,
+            self.src_crc, 0
+        )
+
+    @classmethod
+    def unpack(cls, entry: bytes):
+        (name, part_type, flags, _, offset, size, length, load, crc, src_crc,
+         _) = struct.unpack(ENTRY_FORMAT, entry)
+
+        part = cls(name.rstrip(b'\x00').decode('latin-1'), part_type,
+                   load=load, flags=flags, src_crc=src_crc, offset=offset,
+                   size=size, crc=crc)
+        part.length = length
+
+        return part
+
+
+def pack_table(parts: list, image_size: int) -> bytes:
+    if len(parts) > MAX_PARTS:
+        raise PartError(f'Too many partitions ({len(parts)}, most {MAX_PARTS})')
+
+    entries = b''.join(p.pack() for p in parts)
+    header = struct.pack(HEADER_FORMAT, TABLE_MAGIC, TABLE_VERSION, len(parts),
+                         image_size, crc32(entries))
+
+    return (header + entries).ljust(TABLE_SIZE, b'\xff')
+
+
+def read_table(image: bytes) -> list:
+    """ Return the partitions of an image, with their contents, or None if it
+    has no valid table """
+    if len(image) < TABLE_SIZE:
+        return None
+
+    table = image[-TABLE_SIZE:]
+
+    magic, version, count, size, crc = struct.unpack_from(HEADER_FORMAT, table)
+
+    if (magic != TABLE_MAGIC or version != TABLE_VERSION or
+            size != len(image) or count > MAX_PARTS):
+        return None
+
+    entries = table[HEADER_SIZE:HEADER_SIZE + count * ENTRY_SIZE]
+
+    if crc32(entries) != crc:
+        return None
+
+    parts = []
+
+    for pos in range(0, len(entries), ENTRY_SIZE):
+        part = Partition.unpack(entries[pos:pos + ENTRY_SIZE])
+
+        if part.offset + part.size > len(image) - TABLE_SIZE:
+            return None
+
+        part.data = image[part.offset:part.offset + part.length]
+        parts.append(part)
+
+    return parts
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='List and check the partitions of a ROM image'
+    )
+    parser.add_argument(
+        'image',
+        type=str,
+        help='ROM image made by make_image.py'
+    )
+    args = parser.parse_args()
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+
+    parts = read_table(image)
+
+    if parts is None:
+        print(f'{args.image} has no valid partition table')
+
+        return 1
+
+    bad = 0
+
+    print(f'{"name":8}  {"type":5}  {"offset":>8}  {"size":>8}  {"length":>8}  '
+          f'{"load":>8}  {"crc":8}')
+
+    for p in parts:
+        ok = crc32(p.data) == p.crc
+        bad += 0 if ok else 1
+
+        print(f'{p.name:8}  {type_name(p.type):5}  {p.offset:08X}  '
+              f'{p.size:8}  {p.length:8}  {p.load:08X}  {p.crc:08X}  '
+              f'{"OK" if ok else "BAD"}')
+
+    return 1 if bad else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
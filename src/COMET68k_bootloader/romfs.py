@@ -0,0 +1,197 @@
+# Build a read only filesystem image, to be placed in a ROM partition
+#
+# Lookup tables, fonts, configuration and the like can be kept in a romfs
+# partition rather than linked into each program, and updated on their own.
+# libcomet's romfs.h finds a file by name and returns a pointer to its contents
+# in ROM, so nothing is copied to RAM.
+#
+# Image layout (see libcomet/romfs.h):
+#
+#   header: magic "CRFS", version (16 bits), file count (16 bits), image size,
+#           CRC32 of the directory (entries and names)
+#   entries: offset of name, offset of contents, length, CRC32 of contents,
+#            sorted by name so that they can be searched by halving
+#   names: each terminated by a zero byte
+#   contents: each starting on a multiple of ALIGN bytes
+#
+# Offsets are from the start of the image. All values are most significant byte
+# first. Names are paths relative to the directory the image was built from,
+# separated by /, e.g. fonts/8x16.fnt.
+#
+# Run on its own, this builds an image from a directory, or lists and checks
+# an existing image:
+#
+#   python3 romfs.py -o assets.romfs assets/
+#   python3 romfs.py -l assets.romfs
+#
+# make_image.py builds the image itself when given a directory for a romfs
+# partition, e.g. -p romfs:assets=assets/
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+ROMFS_MAGIC = b'CRFS'
+ROMFS_VERSION = 1
+HEADER_FORMAT = '>4sHHLL'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+ENTRY_FORMAT = '>LLLL'
+ENTRY_SIZE = struct.calcsize(ENTRY_FORMAT)
+MAX_FILES = 0xFFFF
+
+# Contents are aligned so that tables of 32 bit values can be used in place,
+# by any of the 68k family
+ALIGN = 4
+
+
+class RomfsError(Exception):
+    pass
+
+
+def crc32(data: bytes) -> int:
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def align(val: int) -> int:
+    return (val + ALIGN - 1) & ~(ALIGN - 1)
+
+
+def read_dir(path: str) -> dict:
+    """ Return the contents of each file below path, by name """
+    files = {}
+
+    for root, dirs, names in os.walk(path):
+        dirs.sort()
+
+        for name in sorted(names):
+            full = os.path.join(root, name)
+            rel = os.path.relpath(full, path).replace(os.sep, '/')
+
+            with open(full, 'rb') as f:
+                files[rel] = f.read()
+
+    return files
+
+
+def build(files: dict) -> bytes:
+    """ Build an image from a dict of contents by name """
+    if len(files) > MAX_FILES:
+        raise RomfsError(f'Too many files ({len(files)}, most {MAX_FILES})')
+
+    names = sorted(n.encode() for n in files)
+    contents = [files[n.decode()] for n in names]
+
+    for name in names:
+        if len(name) == 0 or b'\x00' in name:
+            raise RomfsError(f'Invalid file name {name!r}')
+
+    name_offset = HEADER_SIZE + len(names) * ENTRY_SIZE
+    data_offset = align(name_offset + sum(len(n) + 1 for n in names))
+
+    entries = b''
+    strings = b''
+    data = b''
+
+    for name, content in zip(names, contents):
+        entries += struct.pack(ENTRY_FORMAT, name_offset + len(strings),
+                               data_offset + len(data), len(content),
+                               crc32(content))
+        strings += name + b'\x00'
+        data += content
+        data += b'\xff' * (align(len(data)) - len(data))
+
+    directory = (entries + strings).ljust(data_offset - HEADER_SIZE, b'\xff')
+    size = HEADER_SIZE + len(directory) + len(data)
+    header = struct.pack(HEADER_FORMAT, ROMFS_MAGIC, ROMFS_VERSION, len(names),
+                         size, crc32(entries + strings))
+
+    return header + directory + data
+
+
+def read(image: bytes) -> dict:
+    """ Return the contents of each file in an image by name, and whether its
+    CRC32 is correct """
+    if len(image) < HEADER_SIZE:
+        raise RomfsError('Image is too short')
+
+    magic, version, count, size, crc = struct.unpack_from(HEADER_FORMAT, image)
+
+    if magic != ROMFS_MAGIC or version != ROMFS_VERSION or size > len(image):
+        raise RomfsError('Not a romfs image')
+
+    files = {}
+    strings_end = HEADER_SIZE + count * ENTRY_SIZE
+
+    for pos in range(HEADER_SIZE, HEADER_SIZE + count * ENTRY_SIZE, ENTRY_SIZE):
+        name, offset, length, file_crc = struct.unpack_from(ENTRY_FORMAT,
+                                                            image, pos)
+        end = image.index(b'\x00', name)
+        strings_end = max(strings_end, end + 1)
+
+        if offset + length > size:
+            raise RomfsError('File lies outside the image')
+
+        content = image[offset:offset + length]
+        files[image[name:end].decode()] = (content,
+                                           crc32(content) == file_crc)
+
+    if crc32(image[HEADER_SIZE:strings_end]) != crc:
+        raise RomfsError('Directory is corrupt')
+
+    return files
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Build or list a read only filesystem image'
+    )
+    parser.add_argument(
+        'path',
+        type=str,
+        help='Directory to build the image from, or image to list'
+    )
+    parser.add_argument(
+        '-o', '--output',
+        dest='output', type=str, default=None,
+        help='Filename of output image'
+    )
+    parser.add_argument(
+        '-l', '--list',
+        dest='list_flag', action='store_true', default=False,
+        help='List and check the files in an existing image'
+    )
+    args = parser.parse_args()
+
+    if args.list_flag:
+        with open(args.path, 'rb') as f:
+            files = read(f.read())
+
+        bad = 0
+
+        for name, (content, ok) in files.items():
+            bad += 0 if ok else 1
+            print(f'{len(content):8}  {"OK " if ok else "BAD"}  {name}')
+
+        return 1 if bad else 0
+
+    if args.output is None:
+        parser.error('an output filename is needed to build an image')
+
+    image = build(read_dir(args.path))
+
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+    print(f'{args.output}: {len(image)} bytes')
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (RomfsError, OSError, ValueError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,207 @@
+#ifndef TL16C2552_H
+#define TL16C2552_H
+
+/* Host model of the TL16C2552 register interface
+ *
+ * This header stands in for ../TL16C2552.h when the bootloader is built for
+ * the host simulator. It is force included ahead of main.c (see Makefile), and
+ * because it shares the same include guard, the real header is skipped when
+ * main.c includes it.
+ *
+ * Only channel A is modelled. Registers that are only ever read are accessed
+ * through functions that service the model. Registers that are written (either
+ * directly or through their bits unions) are accessed through a posted write
+ * slot, which is committed to the model on the next register access. */
+
+#include "COMET68k.h"               /* Generated from COMET68k.dts */
+
+#define UART_BASE DT_SERIAL1_REG_ADDR   /* Base address of the UART */
+
+#define UART_CHA (DT_SERIAL0_REG_ADDR - UART_BASE)
+                                    /* A3 high to access ch A regs.
+                                     * Ch B is accessed with A3 low. */
+
+#define UART_RBR_REG (0)            /* Receiver Buffer Register (r) */
+#define UART_THR_REG (0)            /* Transmitter Holding Register (w) */
+#define UART_IER_REG (0x1)          /* Interrupt Enable Register (r/w) */
+#define UART_IIR_REG (0x2)          /* Interrupt Ident Register (r) */
+#define UART_FCR_REG (0x2)          /* FIFO Control Register (w) */
+#define UART_LCR_REG (0x3)          /* Line Control Register (r/w) */
+#define UART_MCR_REG (0x4)          /* Modem Control Register (r/w) */
+#define UART_LSR_REG (0x5)          /* Line Status Register (r/w) */
+#define UART_MSR_REG (0x6)          /* Modem Status Register (r/w) */
+#define UART_SCR_REG (0x7)          /* Scratch Register (r/w) */
+
+#define UART_DLL_REG (0)            /* LSB of divisor (r/w) */
+#define UART_DLM_REG (0x1)          /* MSB of divisor (r/w) */
+#define UART_AFR_REG (0x2)          /* Alternate Function Register (r/w) */
+
+#include <stdint.h>
+#include "sim.h"
+
+/* The bits unions below match those in ../TL16C2552.h, but with the fields
+ * declared LSB first to suit the bitfield allocation order of the host. */
+typedef union {
+    struct {
+        uint8_t RXDAT:1;
+        uint8_t TXEMPTY:1;
+        uint8_t LSTAT:1;
+        uint8_t MSTAT:1;
+        uint8_t :4;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTIERbits_t;
+
+typedef union {
+    struct {
+        uint8_t IPEND0:1;
+        uint8_t IPEND1:1;
+        uint8_t IPEND2:1;
+        uint8_t IPEND3:1;
+        uint8_t :2;
+        uint8_t FIFOEN0:1;
+        uint8_t FIFOEN1:1;
+    };
+    struct {
+        uint8_t IPEND:4;
+        uint8_t :2;
+        uint8_t FIFOEN:2;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTIIRbits_t;
+
+typedef union {
+    struct {
+        uint8_t EN:1;
+        uint8_t RXRST:1;
+        uint8_t TXRST:1;
+        uint8_t DMASEL:1;
+        uint8_t :2;
+        uint8_t RXTRG0:1;
+        uint8_t RXTRG1:1;
+    };
+    struct {
+        uint8_t :6;
+        uint8_t RXTRG:2;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTFCRbits_t;
+
+typedef union {
+    struct {
+        uint8_t WLEN0:1;
+        uint8_t WLEN1:1;
+        uint8_t SLEN:1;
+        uint8_t PEN:1;
+        uint8_t PEVEN:1;
+        uint8_t PFORCE:1;
+        uint8_t TXBRK:1;
+        uint8_t DLAB:1;
+    };
+    struct {
+        uint8_t WLEN:2;
+        uint8_t :6;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTLCRbits_t;
+
+typedef union {
+    struct {
+        uint8_t DTROC:1;
+        uint8_t RTSOC:1;
+        uint8_t OP1:1;
+        uint8_t OP2:1;
+        uint8_t LOOP:1;
+        uint8_t AUTOFLOW:1;
+        uint8_t :2;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTMCRbits_t;
+
+typedef union {
+    struct {
+        uint8_t RXD:1;
+        uint8_t OERR:1;
+        uint8_t PERR:1;
+        uint8_t FERR:1;
+        uint8_t RXBRK:1;
+        uint8_t THRE:1;
+        uint8_t TXIDL:1;
+        uint8_t RXERR:1;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTLSRbits_t;
+
+typedef union {
+    struct {
+        uint8_t CTSCHG:1;
+        uint8_t DSRCHG:1;
+        uint8_t RICHG:1;
+        uint8_t CDCHG:1;
+        uint8_t CTSSTAT:1;
+        uint8_t DSRSTAT:1;
+        uint8_t RISTAT:1;
+        uint8_t CDSTAT:1;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTMSRbits_t;
+
+typedef union {
+    struct {
+        uint8_t BOTH:1;
+        uint8_t MFSEL0:1;
+        uint8_t MFSEL1:1;
+        uint8_t :5;
+    };
+    struct {
+        uint8_t :1;
+        uint8_t MFSEL:2;
+        uint8_t :5;
+    };
+    struct {
+        uint8_t u8;
+    };
+} __UARTAFRbits_t;
+
+/* Status registers, read only */
+#define UARBR (sim_uart_read(UART_RBR_REG))
+#define UAIIR (sim_uart_read(UART_IIR_REG))
+#define UAIIRbits ((__UARTIIRbits_t){ .u8 = UAIIR })
+#define UALSR (sim_uart_read(UART_LSR_REG))
+#define UALSRbits ((__UARTLSRbits_t){ .u8 = UALSR })
+#define UAMSR (sim_uart_read(UART_MSR_REG))
+#define UAMSRbits ((__UARTMSRbits_t){ .u8 = UAMSR })
+
+/* Control registers, written through the posted write slot */
+#define UATHR (*sim_uart_post(UART_THR_REG))
+#define UAIER (*sim_uart_post(UART_IER_REG))
+#define UAIERbits (*(volatile __UARTIERbits_t *)sim_uart_post(UART_IER_REG))
+#define UAFCR (*sim_uart_post(UART_FCR_REG))
+#define UAFCRbits (*(volatile __UARTFCRbits_t *)sim_uart_post(UART_FCR_REG))
+#define UALCR (*sim_uart_post(UART_LCR_REG))
+#define UALCRbits (*(volatile __UARTLCRbits_t *)sim_uart_post(UART_LCR_REG))
+#define UAMCR (*sim_uart_post(UART_MCR_REG))
+#define UAMCRbits (*(volatile __UARTMCRbits_t *)sim_uart_post(UART_MCR_REG))
+#define UASCR (*sim_uart_post(UART_SCR_REG))
+#define UADLL (*sim_uart_post(UART_DLL_REG))
+#define UADLM (*sim_uart_post(UART_DLM_REG))
+#define UAAFR (*sim_uart_post(UART_AFR_REG))
+#define UAAFRbits (*(volatile __UARTAFRbits_t *)sim_uart_post(UART_AFR_REG))
+
+/* Channel B is not modelled */
+
+#endif /* TL16C2552_H */
@@ -0,0 +1,697 @@
+/* Host simulator for the COMET68k bootloader
+ *
+ * The bootloader state machine in ../main.c is compiled for the host and run
+ * against a model of the TL16C2552 UART (channel A) and the 68000 address
+ * space. The UART is exposed to the outside world through a pseudo-terminal,
+ * so the loader scripts can talk to the simulator exactly as they would talk
+ * to the hardware through a USB serial adapter.
+ *
+ * Optionally, the time taken to shift each character in and out of the UART
+ * at the programmed baud rate can be modelled, which makes the simulator useful
+ * for measuring protocol throughput as well as for functional testing. */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TL16C2552.h"
+
+/* The bootloader entry point, renamed at compile time (see Makefile) */
+int bootloader_main(void);
+
+/* Depth of the TL16C2552 transmit FIFO */
+#define TX_FIFO_DEPTH 16
+
+/* Size of the software buffers standing in for the serial line in each
+ * direction. These are much deeper than the UART FIFOs, they simply hold the
+ * characters that are "on the wire". */
+#define LINE_BUF_SIZE 65536
+
+typedef struct {
+    uint8_t data[LINE_BUF_SIZE];
+    uint64_t time[LINE_BUF_SIZE];   /* Arrival (rx) or completion (tx) time */
+    unsigned int head;
+    unsigned int count;
+} line_buf_t;
+
+/* Command line options */
+static int opt_pace = 0;
+static int opt_verbose = 0;
+static const char *opt_link = NULL;
+static const char *opt_rom = NULL;
+
+/* Pseudo-terminal */
+static int pty_master = -1;
+static int pty_slave = -1;
+
+/* UART channel A register model */
+static uint8_t reg_ier;
+static uint8_t reg_fcr;
+static uint8_t reg_lcr = 0x03;
+static uint8_t reg_mcr;
+static uint8_t reg_scr;
+static uint8_t reg_dll = 1;
+static uint8_t reg_dlm;
+static uint8_t reg_afr;
+static uint8_t last_lsr;
+
+/* Posted register write */
+static volatile uint8_t post_val;
+static int post_reg = -1;
+
+/* Set while the bootloader is polling the LSR without touching anything else,
+ * which is used to detect that it is idle and waiting on the model */
+static int lsr_polling;
+
+static line_buf_t rx_line;
+static line_buf_t tx_line;
+
+/* Statistics */
+static unsigned long stat_rx_bytes;
+static unsigned long stat_tx_bytes;
+static unsigned long stat_tx_overruns;
+static unsigned long stat_executes;
+
+/* Memory model */
+uint8_t *sim_mem;
+
+static jmp_buf reset_env;
+static volatile sig_atomic_t stop_requested;
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Time taken to shift one character at the currently programmed line
+ * settings. Returns 0 when delays are not being modelled. */
+static uint64_t
+char_time_ns(void)
+{
+    unsigned int divisor = ((unsigned int)reg_dlm << 8) | reg_dll;
+    unsigned int bits;
+
+    if (!opt_pace) {
+        return 0;
+    }
+
+    if (divisor == 0) {
+        divisor = 1;
+    }
+
+    /* Start bit, data bits, optional parity bit and stop bit(s). 1.5 stop bits
+     * is rounded up to 2. */
+    bits = 1 + 5 + (reg_lcr & 0x3);
+    bits += (reg_lcr & 0x08) ? 1 : 0;
+    bits += (reg_lcr & 0x04) ? 2 : 1;
+
+    return (uint64_t)bits * divisor * 16 * 1000000000ULL / SIM_UART_CLOCK;
+}
+
+static void
+sim_exit(void)
+{
+    fprintf(stderr, "\ncomet68k-sim: rx %lu bytes, tx %lu bytes, "
+            "%lu tx FIFO overruns, %lu executes\n",
+            stat_rx_bytes, stat_tx_bytes, stat_tx_overruns, stat_executes);
+
+    if (opt_link != NULL) {
+        unlink(opt_link);
+    }
+
+    exit(0);
+}
+
+static void
+handle_signal(int sig)
+{
+    (void)sig;
+
+    stop_requested = 1;
+}
+
+/* Move characters between the pseudo-terminal and the line buffers */
+static void
+service_line(void)
+{
+    uint64_t now = now_ns();
+    uint64_t ct = char_time_ns();
+    uint8_t buf[1024];
+    ssize_t len;
+    ssize_t i;
+
+    if (stop_requested) {
+        sim_exit();
+    }
+
+    /* Receive as much as will fit in the line buffer. When modelling delays,
+     * each character arrives one character time after the previous one. */
+    while (rx_line.count < LINE_BUF_SIZE) {
+        size_t want = LINE_BUF_SIZE - rx_line.count;
+
+        len = read(pty_master, buf, want < sizeof(buf) ? want : sizeof(buf));
+
+        if (len <= 0) {
+            break;
+        }
+
+        for (i = 0; i < len; i++) {
+            unsigned int tail = (rx_line.head + rx_line.count) % LINE_BUF_SIZE;
+            uint64_t t = now;
+
+            if (ct != 0 && rx_line.count > 0) {
+                unsigned int prev = (tail + LINE_BUF_SIZE - 1) % LINE_BUF_SIZE;
+
+                if (rx_line.time[prev] > t) {
+                    t = rx_line.time[prev];
+                }
+            }
+
+            rx_line.data[tail] = buf[i];
+            rx_line.time[tail] = t + ct;
+            rx_line.count++;
+        }
+    }
+
+    /* Transmit characters which have finished shifting out */
+    while (tx_line.count > 0 && tx_line.time[tx_line.head] <= now) {
+        uint8_t c = tx_line.data[tx_line.head];
+
+        if (write(pty_master, &c, 1) != 1) {
+            if (errno == EAGAIN) {
+                break;
+            }
+        }
+
+        tx_line.head = (tx_line.head + 1) % LINE_BUF_SIZE;
+        tx_line.count--;
+        stat_tx_bytes++;
+    }
+}
+
+static void
+transmit(uint8_t c)
+{
+    uint64_t now = now_ns();
+    uint64_t ct = char_time_ns();
+    unsigned int tail;
+    unsigned int waiting = tx_line.count;
+    uint64_t t = now;
+
+    /* Characters that have not yet started shifting occupy the FIFO */
+    if (waiting > 0 && tx_line.time[tx_line.head] - ct <= now) {
+        waiting--;
+    }
+
+    if (waiting >= TX_FIFO_DEPTH) {
+        stat_tx_overruns++;
+
+        if (opt_verbose) {
+            fprintf(stderr, "comet68k-sim: tx FIFO overrun\n");
+        }
+    }
+
+    if (tx_line.count == LINE_BUF_SIZE) {
+        /* The host is not reading, drop the character */
+        return;
+    }
+
+    tail = (tx_line.head + tx_line.count) % LINE_BUF_SIZE;
+
+    if (tx_line.count > 0) {
+        unsigned int prev = (tail + LINE_BUF_SIZE - 1) % LINE_BUF_SIZE;
+
+        if (tx_line.time[prev] > t) {
+            t = tx_line.time[prev];
+        }
+    }
+
+    tx_line.data[tail] = c;
+    tx_line.time[tail] = t + ct;
+    tx_line.count++;
+
+    service_line();
+}
+
+static uint8_t
+compute_lsr(void)
+{
+    uint64_t now = now_ns();
+    uint64_t ct = char_time_ns();
+    uint8_t lsr = 0;
+
+    if (rx_line.count > 0 && rx_line.time[rx_line.head] <= now) {
+        lsr |= 0x01;                /* RXD */
+    }
+
+    /* THRE is set once the FIFO is empty, i.e. at most one character remains
+     * and it is already in the shift register */
+    if (tx_line.count == 0 ||
+        (tx_line.count == 1 && tx_line.time[tx_line.head] - ct <= now)) {
+        lsr |= 0x20;                /* THRE */
+    }
+
+    if (tx_line.count == 0) {
+        lsr |= 0x40;                /* TXIDL */
+    }
+
+    return lsr;
+}
+
+/* Block until the next event that could change the LSR, which is either the
+ * arrival of a character or a character finishing being transmitted */
+static void
+wait_for_event(void)
+{
+    uint64_t now = now_ns();
+    uint64_t next = 0;
+    uint64_t wait;
+    struct pollfd pfd;
+    struct timespec ts;
+
+    if (tx_line.count > 0) {
+        next = tx_line.time[tx_line.head];
+    }
+
+    if (rx_line.count > 0 && (next == 0 || rx_line.time[rx_line.head] < next)) {
+        next = rx_line.time[rx_line.head];
+    }
+
+    if (next != 0 && next <= now) {
+        return;
+    }
+
+    if (next == 0 && rx_line.count == LINE_BUF_SIZE) {
+        return;
+    }
+
+    /* Wake up periodically regardless, so that a signal arriving just before
+     * the poll is not missed for long */
+    wait = 250000000ULL;
+
+    if (next != 0 && next - now < wait) {
+        wait = next - now;
+    }
+
+    ts.tv_sec = wait / 1000000000ULL;
+    ts.tv_nsec = wait % 1000000000ULL;
+
+    pfd.fd = pty_master;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    ppoll(&pfd, 1, &ts, NULL);
+}
+
+static void
+commit_post(void)
+{
+    int dlab = (reg_lcr & 0x80) != 0;
+    uint8_t val = post_val;
+    int reg = post_reg;
+
+    if (reg < 0) {
+        return;
+    }
+
+    post_reg = -1;
+
+    switch (reg) {
+        case UART_THR_REG:
+            if (dlab) {
+                reg_dll = val;
+            } else {
+                transmit(val);
+            }
+
+            break;
+
+        case UART_IER_REG:
+            if (dlab) {
+                reg_dlm = val;
+            } else {
+                reg_ier = val;
+            }
+
+            break;
+
+        case UART_FCR_REG:
+            if (dlab) {
+                reg_afr = val;
+            } else {
+                reg_fcr = val;
+
+                if (val & 0x02) {
+                    /* Receiver FIFO reset discards anything received but not
+                     * yet read, as on the hardware */
+                    rx_line.count = 0;
+                }
+            }
+
+            break;
+
+        case UART_LCR_REG:
+            reg_lcr = val;
+
+            break;
+
+        case UART_MCR_REG:
+            reg_mcr = val;
+
+            break;
+
+        case UART_SCR_REG:
+            reg_scr = val;
+
+            break;
+
+        default:
+            break;
+    }
+}
+
+static uint8_t
+current_value(unsigned int reg)
+{
+    int dlab = (reg_lcr & 0x80) != 0;
+
+    switch (reg) {
+        case UART_DLL_REG:
+            return dlab ? reg_dll : 0;
+
+        case UART_IER_REG:
+            return dlab ? reg_dlm : reg_ier;
+
+        case UART_FCR_REG:
+            return dlab ? reg_afr : reg_fcr;
+
+        case UART_LCR_REG:
+            return reg_lcr;
+
+        case UART_MCR_REG:
+            return reg_mcr;
+
+        case UART_SCR_REG:
+            return reg_scr;
+
+        default:
+            return 0;
+    }
+}
+
+uint8_t
+sim_uart_read(unsigned int reg)
+{
+    uint8_t val = 0;
+
+    commit_post();
+    service_line();
+
+    switch (reg) {
+        case UART_RBR_REG:
+            lsr_polling = 0;
+
+            if ((reg_lcr & 0x80) != 0) {
+                return reg_dll;
+            }
+
+            if (rx_line.count > 0) {
+                val = rx_line.data[rx_line.head];
+                rx_line.head = (rx_line.head + 1) % LINE_BUF_SIZE;
+                rx_line.count--;
+                stat_rx_bytes++;
+            }
+
+            return val;
+
+        case UART_LSR_REG:
+            val = compute_lsr();
+
+            /* Reading the same LSR value twice in a row without any other
+             * access in between means the bootloader is spinning on a status
+             * bit, so wait until something happens rather than burning CPU */
+            if (lsr_polling && val == last_lsr) {
+                wait_for_event();
+                service_line();
+                val = compute_lsr();
+            }
+
+            lsr_polling = 1;
+            last_lsr = val;
+
+            return val;
+
+        case UART_IIR_REG:
+            lsr_polling = 0;
+
+            return 0xC1;            /* FIFOs enabled, no interrupt pending */
+
+        case UART_MSR_REG:
+            lsr_polling = 0;
+
+            return 0xB0;            /* CD, DSR and CTS asserted */
+
+        default:
+            lsr_polling = 0;
+
+            return current_value(reg);
+    }
+}
+
+volatile uint8_t *
+sim_uart_post(unsigned int reg)
+{
+    commit_post();
+
+    lsr_polling = 0;
+
+    /* Preload the slot so that read-modify-write of a bits union works */
+    post_val = current_value(reg);
+    post_reg = (int)reg;
+
+    return &post_val;
+}
+
+uint16_t
+sim_mem_rd16(const volatile uint16_t *ptr)
+{
+    const volatile uint8_t *p = (const volatile uint8_t *)ptr;
+
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+uint32_t
+sim_mem_rd32(const volatile uint32_t *ptr)
+{
+    const volatile uint8_t *p = (const volatile uint8_t *)ptr;
+
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+void
+sim_mem_wr16(volatile uint16_t *ptr, uint16_t val)
+{
+    volatile uint8_t *p = (volatile uint8_t *)ptr;
+
+    p[0] = val >> 8;
+    p[1] = val;
+}
+
+void
+sim_mem_wr32(volatile uint32_t *ptr, uint32_t val)
+{
+    volatile uint8_t *p = (volatile uint8_t *)ptr;
+
+    p[0] = val >> 24;
+    p[1] = val >> 16;
+    p[2] = val >> 8;
+    p[3] = val;
+}
+
+void
+sim_execute(uint32_t addr, int jump)
+{
+    stat_executes++;
+
+    if (jump) {
+        /* Control never comes back from a JMP, so treat it as though the user
+         * code ran and the board was then reset. DRAM contents are kept, as
+         * they are on the hardware. */
+        fprintf(stderr, "comet68k-sim: JMP to 0x%08X, resetting\n", addr);
+
+        longjmp(reset_env, 1);
+    }
+
+    fprintf(stderr, "comet68k-sim: JSR to 0x%08X, returning\n", addr);
+}
+
+static int
+open_pty(void)
+{
+    struct termios tio;
+    const char *name;
+
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (pty_master < 0 || grantpt(pty_master) != 0 ||
+        unlockpt(pty_master) != 0) {
+        perror("comet68k-sim: pseudo-terminal");
+        return -1;
+    }
+
+    name = ptsname(pty_master);
+
+    /* Keep the slave side open ourselves, so that the master does not see a
+     * hangup each time a loader script closes the port */
+    pty_slave = open(name, O_RDWR | O_NOCTTY);
+
+    if (pty_slave < 0) {
+        perror("comet68k-sim: pseudo-terminal slave");
+        return -1;
+    }
+
+    /* Raw mode, so the line discipline does not mangle binary data */
+    tcgetattr(pty_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty_slave, TCSANOW, &tio);
+
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+
+    if (opt_link != NULL) {
+        unlink(opt_link);
+
+        if (symlink(name, opt_link) != 0) {
+            perror("comet68k-sim: symlink");
+            return -1;
+        }
+    }
+
+    printf("%s\n", opt_link != NULL ? opt_link : name);
+    fflush(stdout);
+
+    return 0;
+}
+
+static int
+load_rom(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    size_t len;
+
+    if (f == NULL) {
+        perror(filename);
+        return -1;
+    }
+
+    len = fread(sim_mem + SIM_ROM_BASE, 1, SIM_ROM_SIZE, f);
+
+    fclose(f);
+
+    if (opt_verbose) {
+        fprintf(stderr, "comet68k-sim: loaded %zu bytes of ROM at 0x%08X\n",
+                len, SIM_ROM_BASE);
+    }
+
+    return 0;
+}
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-d] [-v] [-l link] [-r rom_image]\n"
+            "\n"
+            "  -d          Model character times at the programmed baud rate\n"
+            "  -l link     Create a symlink to the pseudo-terminal at link\n"
+            "  -r image    Load a ROM image at 0x%08X\n"
+            "  -v          Verbose output\n"
+            "\n"
+            "The name of the pseudo-terminal (or link) is printed on stdout.\n",
+            prog, SIM_ROM_BASE);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct sigaction sa;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "dhl:r:v")) != -1) {
+        switch (opt) {
+            case 'd':
+                opt_pace = 1;
+                break;
+
+            case 'l':
+                opt_link = optarg;
+                break;
+
+            case 'r':
+                opt_rom = optarg;
+                break;
+
+            case 'v':
+                opt_verbose = 1;
+                break;
+
+            case 'h':
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    /* Address space, initially filled as though unprogrammed/unpopulated */
+    sim_mem = mmap(NULL, SIM_MEM_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (sim_mem == MAP_FAILED) {
+        perror("comet68k-sim: mmap");
+        return 1;
+    }
+
+    memset(sim_mem, 0xFF, SIM_MEM_SIZE);
+
+    if (opt_rom != NULL && load_rom(opt_rom) != 0) {
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (open_pty() != 0) {
+        return 1;
+    }
+
+    /* The bootloader never returns, other than through sim_exit(). A JMP to
+     * user code brings us back here to start it over. */
+    setjmp(reset_env);
+
+    post_reg = -1;
+    lsr_polling = 0;
+
+    bootloader_main();
+
+    sim_exit();
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#define SIM_HOST 1
+
+/* The UART clock, as fitted to COMET68k */
+#define SIM_UART_CLOCK 7372800
+
+/* The 68000 has a 24 bit address bus, so the entire address space is modelled
+ * as a flat array. A further 16MB is allocated beyond the end so that long
+ * transfers walking off the end of the address space stay within the array
+ * (address wrap-around is not modelled). */
+#define SIM_ADDR_MASK 0x00FFFFFF
+#define SIM_MEM_SIZE (2 * (SIM_ADDR_MASK + 1))
+
+/* Where a ROM image given on the command line is loaded */
+#define SIM_ROM_BASE 0x00F80000
+#define SIM_ROM_SIZE (512 * 1024)
+
+/* UART register model */
+uint8_t sim_uart_read(unsigned int reg);
+volatile uint8_t *sim_uart_post(unsigned int reg);
+
+/* Memory model */
+extern uint8_t *sim_mem;
+
+uint16_t sim_mem_rd16(const volatile uint16_t *ptr);
+uint32_t sim_mem_rd32(const volatile uint32_t *ptr);
+void sim_mem_wr16(volatile uint16_t *ptr, uint16_t val);
+void sim_mem_wr32(volatile uint32_t *ptr, uint32_t val);
+
+/* Execution of user code */
+void sim_execute(uint32_t addr, int jump);
+
+/* Target memory accessors used by main.c. Memory is held in 68000 (big endian)
+ * byte order, so that data written as words or longs reads back byte for byte
+ * the same as it would on the hardware. */
+#define MEM_PTR(addr) (sim_mem + ((uint32_t)(addr) & SIM_ADDR_MASK))
+#define MEM_RD16(ptr) sim_mem_rd16(ptr)
+#define MEM_RD32(ptr) sim_mem_rd32(ptr)
+#define MEM_WR16(ptr, val) sim_mem_wr16((ptr), (val))
+#define MEM_WR32(ptr, val) sim_mem_wr32((ptr), (val))
+
+#endif /* SIM_H */
@@ -1,20 +1,120 @@
+import os
 import sys
 import re
 import json
 import copy
+import argparse
+
+# C++ keywords that a field name could turn into once made lower case
+CPP_KEYWORDS = {'and', 'bool', 'case', 'char', 'do', 'else', 'for', 'if',
+                'int', 'long', 'new', 'not', 'or', 'short', 'this', 'xor'}
+
+
+def cpp_name(name: str) -> str:
+    name = name.lower()
+
+    return f'{name}_' if name in CPP_KEYWORDS else name
+
+
+def write_cpp(filename: str, header: str, unions: dict, regs: list) -> None:
+    """ Write a C++ header describing each register and its fields with
+    mmio.hpp. Each union becomes a register template, taking its address, with
+    a constexpr descriptor for each field, and each register an alias of one of
+    these, or of a plain mmio::reg if it has no fields. """
+    header_name = os.path.basename(header)
+    namespace = cpp_name(os.path.splitext(header_name)[0])
+    guard = re.sub(r'\W', '_', os.path.basename(filename)).upper()
+    reg_unions = {}
+
+    for union in unions:
+        for reg in unions[union]['regs']:
+            reg_unions[reg] = union
+
+    lines = [
+        f'/* Generated by structbits.py from {header_name}, do not edit. To '
+        'regenerate:',
+        ' *',
+        f' *   python3 structbits.py {header_name} -c {os.path.basename(filename)}',
+        ' *',
+        ' * Each register is a type, with a constexpr descriptor for each of its',
+        ' * fields, named as in the bitfield unions but in lower case. Calling a',
+        ' * descriptor gives the field\'s value in position, and values for fields of',
+        ' * the same register are combined with | and written in one store:',
+        ' *',
+        f' *   using namespace {namespace};',
+        ' *   ualcr::write(ualcr::dlab(1) | ualcr::wlen(3));',
+        ' *',
+        ' * rather than a read, modify and write for each field as with the unions.',
+        ' * modify() keeps the fields that are not given. */',
+        '',
+        f'#ifndef {guard}',
+        f'#define {guard}',
+        '',
+        '#include <stdint.h>',
+        f'#include "{header_name}"',
+        '#include "mmio.hpp"',
+        '',
+        f'namespace {namespace} {{',
+    ]
+
+    for union in unions:
+        reg_type = f'uint{unions[union]["bits"]}_t'
+        base = f'mmio::reg<Addr, {reg_type}>'
+
+        lines.append('')
+        lines.append('template <uintptr_t Addr>')
+        lines.append(f'struct {cpp_name(union)} : {base} {{')
+
+        for field, info in sorted(unions[union]['fields'].items(),
+                                  key=lambda f: -f[1]['position']):
+            lines.append(
+                f'    static constexpr mmio::field<{base}, {info["position"]}, '
+                f'{info["length"]}> {cpp_name(field)}{{}};'
+            )
+
+        lines.append('};')
+
+    lines.append('')
+
+    for reg, reg_type, addr in regs:
+        if reg in reg_unions:
+            lines.append(f'using {cpp_name(reg)} = '
+                         f'{cpp_name(reg_unions[reg])}<{addr}>;')
+        else:
+            lines.append(f'using {cpp_name(reg)} = mmio::reg<{addr}, {reg_type}>;')
+
+    lines += [
+        '',
+        '}',
+        '',
+        f'#endif /* {guard} */',
+        '',
+    ]
+
+    with open(filename, 'w') as f:
+        f.write('\n'.join(lines))
+
 
 def main() -> None:
     """ Process the input file to extract all struct bits and names and
     produce constants for bit position, mask and length.
     """
-    try:
-        filename = sys.argv[1]
-    except IndexError:
-        filename = None
-    
-    if filename is None:
-        print('Must specify header filename as argument')
-        return
+    parser = argparse.ArgumentParser(
+        description='Produce assembler constants for the bitfields of a '
+                    'register header, and optionally a C++ header'
+    )
+    parser.add_argument(
+        'filename',
+        type=str,
+        help='Register header, e.g. TL16C2552.h'
+    )
+    parser.add_argument(
+        '-c', '--cpp',
+        dest='cpp', type=str, default=None,
+        help='Also write a C++ header of registers and fields for mmio.hpp'
+    )
+    args = parser.parse_args()
+    filename = args.filename
 
     start_of_union_re = re.compile(r'^typedef union')
     end_of_union_re = re.compile(r'^\} (.+);')
@@ -25,9 +125,11 @@ def main() -> None:
     numbered_field_re = re.compile(r'^([a-zA-Z_]+)(\d*)')
     dependent_reg_re = re.compile(r'^#define (.+?)bits .+volatile __(.+)bits_t')
     asm_def_re = re.compile(r'^#define (\w+?)(bits)? \(\*\(.+(\(.+?\))')
+    reg_type_re = re.compile(r'^#define \w+ \(\*\(volatile (\w+) \*\)')
 
     unions = {}
     union = {}
+    regs = []
 
     with open(filename, 'r') as h:
         in_union = False
@@ -45,6 +147,11 @@ def main() -> None:
 
                     print(f'#define {def_var} {def_val}')
 
+                    reg_type = reg_type_re.match(line)
+
+                    if reg_type and def_var not in [r[0] for r in regs]:
+                        regs.append((def_var, reg_type[1], def_val))
+
             if in_union is False and in_struct is False:
                 # Look for a register with struct type
                 match = dependent_reg_re.match(line)
@@ -115,6 +222,7 @@ def main() -> None:
                 if bits is None:
                     bits = int(match[1])
                     pos = bits
+                    union['bits'] = bits
 
                 pos -= length
 
@@ -230,5 +338,8 @@ def main() -> None:
                     print(f'#define {var_len:50} 0x{length:08X}')
                     print()
 
+    if args.cpp is not None:
+        write_cpp(args.cpp, filename, unions, regs)
+
 if __name__ == '__main__':
     main()
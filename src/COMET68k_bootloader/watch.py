@@ -0,0 +1,532 @@
+# Read and decode program variables by name via the bootloader
+#
+# Variable addresses and types are taken from the ELF file of the program
+# running on the target (e.g. bmbinary), using its DWARF debugging information
+# where present, or its symbol table otherwise. Variables are given by name,
+# and may be narrowed down to a structure member or array element:
+#
+#   python3 watch.py bmbinary state rx_count buffer[3] config.flags
+#
+# The type of a variable can be overridden by following it with a colon and a
+# type, e.g. buffer:u8[16]. This also allows a raw address to be read, e.g.
+# 0x1000:u32. Types are u8, s8, u16, s16, u32, s32, f32, f64, char and ptr.
+#
+# Reads are planned so as to use as few bootloader transactions as possible.
+# Variables that are close together are fetched in the same read if the bytes
+# between them take less time to transfer than the overhead of a separate
+# command. Raw addresses may be peripheral registers, where a read can have side
+# effects, so only the bytes asked for are read at them, and never a gap. The next read is always queued while the response to the previous one
+# is arriving, so the link is kept busy.
+#
+# With --watch, the variables are read continuously and the display refreshed,
+# along with the rate at which the whole set is being read.
+
+import argparse
+import re
+import struct
+import sys
+import time
+
+from bootproto import BootloaderLink, BootloaderError, RW_HEADER_LEN
+from dwarf import (DwarfInfo, BaseType, PointerType, EnumType, ArrayType,
+                   StructType, DW_ATE_boolean, DW_ATE_float, DW_ATE_signed,
+                   DW_ATE_signed_char, DW_ATE_unsigned)
+from imagefile import ElfFile, STT_OBJECT
+from loader4 import DEV, BAUD
+
+TYPES = {
+    'u8': BaseType('uint8_t', 1, DW_ATE_unsigned),
+    's8': BaseType('int8_t', 1, DW_ATE_signed),
+    'u16': BaseType('uint16_t', 2, DW_ATE_unsigned),
+    's16': BaseType('int16_t', 2, DW_ATE_signed),
+    'u32': BaseType('uint32_t', 4, DW_ATE_unsigned),
+    's32': BaseType('int32_t', 4, DW_ATE_signed),
+    'f32': BaseType('float', 4, DW_ATE_float),
+    'f64': BaseType('double', 8, DW_ATE_float),
+    'char': BaseType('char', 1, DW_ATE_signed_char),
+    'ptr': PointerType('void *', 4),
+}
+
+EXPR_RE = re.compile(r'^([A-Za-z_]\w*|0[xX][0-9A-Fa-f]+|\d+)((?:\.\w+|\[\d+\])*)$')
+SELECTOR_RE = re.compile(r'\.(\w+)|\[(\d+)\]')
+TYPE_RE = re.compile(r'^(\w+)((?:\[\d+\])*)$')
+
+
+class Item:
+    """ A single value to be read: its location, type, and for bitfields the
+    position of the field within the bytes read """
+    def __init__(self, label: str, addr: int, itype, bit_size: int = None,
+                 bit_offset: int = None, raw: bool = False):
+        self.label = label
+        self.addr = addr
+        self.type = itype
+        self.bit_size = bit_size
+        self.bit_offset = bit_offset
+        self.raw = raw
+
+    @property
+    def size(self) -> int:
+        if self.bit_size is not None:
+            return (self.bit_offset + self.bit_size + 7) // 8
+
+        return self.type.size
+
+
+class Symbols:
+    """ Look up variables by name in an ELF file """
+    def __init__(self, filename: str):
+        self.elf = ElfFile(filename)
+        self.endian = self.elf.endian
+        self.variables = {}
+
+        dwarf = DwarfInfo(self.elf)
+
+        # Where a static variable name is used in more than one place, the
+        # first is taken
+        for v in dwarf.variables():
+            self.variables.setdefault(v.name, v)
+
+        if not dwarf.present:
+            print(f'{filename} has no debugging information, types are '
+                  'guessed from symbol sizes', file=sys.stderr)
+
+    def lookup(self, name: str) -> tuple:
+        """ Return the address and type of a variable """
+        if name in self.variables:
+            v = self.variables[name]
+
+            return (v.addr, v.type)
+
+        sym = self.elf.symbol(name)
+
+        if sym is None:
+            raise ValueError(f'No symbol named {name}')
+
+        if sym.type != STT_OBJECT or sym.size == 0:
+            return (sym.value, None)
+
+        for t in TYPES.values():
+            if t.size == sym.size and t.encoding == DW_ATE_unsigned:
+                return (sym.value, t)
+
+        return (sym.value, ArrayType(TYPES['u8'], sym.size))
+
+    def listing(self) -> list:
+        """ Return every variable as a tuple of address, size, type name and
+        variable name """
+        if self.variables:
+            return sorted(
+                (v.addr, v.type.size, v.type.name, v.name)
+                for v in self.variables.values()
+            )
+
+        return sorted(
+            (s.value, s.size, '', s.name)
+            for s in self.elf.symbols
+            if s.type == STT_OBJECT
+        )
+
+
+def parse_type(spec: str):
+    m = TYPE_RE.match(spec)
+
+    if m is None or m.group(1) not in TYPES:
+        raise ValueError(f'Unknown type {spec}')
+
+    t = TYPES[m.group(1)]
+
+    for count in reversed(re.findall(r'\[(\d+)\]', m.group(2))):
+        t = ArrayType(t, int(count))
+
+    return t
+
+
+def parse_item(spec: str, symbols: Symbols) -> Item:
+    """ Turn a variable given on the command line into an Item """
+    expr, _, type_spec = spec.partition(':')
+    m = EXPR_RE.match(expr)
+
+    if m is None:
+        raise ValueError(f'Cannot parse {spec}')
+
+    base = m.group(1)
+
+    if base[0].isdigit():
+        addr, itype = int(base, 0), None
+    else:
+        addr, itype = symbols.lookup(base)
+
+    item = Item(spec, addr, itype, raw=base[0].isdigit())
+
+    for member, index in SELECTOR_RE.findall(m.group(2)):
+        if member:
+            if not isinstance(item.type, StructType):
+                raise ValueError(f'{spec}: .{member} is not in a structure')
+
+            for mem in item.type.members:
+                if mem.name == member:
+                    break
+            else:
+                raise ValueError(f'{spec}: no member named {member}')
+
+            item = Item(spec, item.addr + mem.offset, mem.type, mem.bit_size,
+                        mem.bit_offset, item.raw)
+        else:
+            if not isinstance(item.type, ArrayType):
+                raise ValueError(f'{spec}: [{index}] is not in an array')
+
+            if int(index) >= item.type.count:
+                raise ValueError(f'{spec}: index {index} is out of range')
+
+            element = item.type.element
+            item = Item(spec, item.addr + int(index) * element.size, element,
+                        raw=item.raw)
+
+    if type_spec:
+        item.type = parse_type(type_spec)
+        item.bit_size = item.bit_offset = None
+
+    if item.type is None:
+        raise ValueError(f'{spec}: type is not known, give one with :type')
+
+    if item.size == 0:
+        raise ValueError(f'{spec}: has no size')
+
+    return item
+
+
+def plan_reads(items: list, max_gap: int, align: int) -> list:
+    """ Work out the reads needed to fetch all items. Each read is a tuple of
+    address, count and width. Items closer together than max_gap bytes are
+    covered by the same read, unless either is at a raw address, when only
+    items which touch or overlap are. Reads are made align bytes wide where
+    possible so that whole words and longs are read in one access, which also
+    means aligned variables of that size are read atomically. A range which
+    does not start or end on a multiple of align is started or finished with
+    narrower reads, so that nothing outside it is read. """
+    ranges = []
+
+    for item in sorted(items, key=lambda i: i.addr):
+        start = item.addr
+        end = item.addr + item.size
+        gap = 0 if item.raw or (ranges and ranges[-1][2]) else max_gap
+
+        if ranges and start <= ranges[-1][1] + gap:
+            ranges[-1][1] = max(ranges[-1][1], end)
+            ranges[-1][2] = item.raw
+        else:
+            ranges.append([start, end, item.raw])
+
+    reads = []
+
+    for start, end, _ in ranges:
+        while start < end:
+            width = align
+
+            while width > 1 and (start % width != 0 or start + width > end):
+                width //= 2
+
+            # Up to the first aligned address, one narrower read at a time
+            count = (end - start) // width if start % align == 0 else 1
+            reads.append((start, count, width))
+            start += count * width
+
+    return reads
+
+
+class Fetcher:
+    """ Issue a fixed set of reads over and over. The next read is sent before
+    the response to the current one has been received, including across the
+    end of one pass and the start of the next, so there is always one command
+    waiting in the bootloader's receive FIFO. """
+    def __init__(self, link: BootloaderLink, reads: list):
+        self.link = link
+        self.reads = reads
+        self.pending = False
+
+    def fetch(self, more: bool = False) -> dict:
+        """ Run every read once, returning a map of address to bytes. If more
+        is set, the first read of the next pass is left queued. """
+        result = {}
+        reads = self.reads
+
+        if not self.pending:
+            self.link.send_read(*reads[0])
+
+        for i, (addr, count, width) in enumerate(reads):
+            if i + 1 < len(reads):
+                self.link.send_read(*reads[i + 1])
+            elif more:
+                self.link.send_read(*reads[0])
+
+            result[addr] = self.link.recv_read(count, width)
+
+        self.pending = more
+
+        return result
+
+
+def extract(item: Item, reads: list, data: dict) -> bytes:
+    """ Gather the bytes of an item, which may span more than one read """
+    value = bytearray(item.size)
+    found = 0
+
+    for addr, count, width in reads:
+        start = max(addr, item.addr)
+        end = min(addr + count * width, item.addr + item.size)
+
+        if start < end:
+            value[start - item.addr:end - item.addr] = \
+                data[addr][start - addr:end - addr]
+            found += end - start
+
+    return bytes(value) if found == item.size else None
+
+
+def bitfield(data: bytes, bit_size: int, bit_offset: int, endian: str) -> int:
+    """ Extract a bitfield. For big endian targets bit_offset counts from the
+    most significant bit of the first byte, for little endian targets from the
+    least significant. """
+    if endian == '>':
+        val = int.from_bytes(data, 'big') >> (len(data) * 8 - bit_offset - bit_size)
+    else:
+        val = int.from_bytes(data, 'little') >> bit_offset
+
+    return val & ((1 << bit_size) - 1)
+
+
+def decode(t, data: bytes, endian: str, hex_ints: bool) -> str:
+    order = 'little' if endian == '<' else 'big'
+
+    if isinstance(t, BaseType):
+        if t.encoding == DW_ATE_float and t.size in (4, 8):
+            return repr(struct.unpack(endian + ('f' if t.size == 4 else 'd'),
+                                      data)[0])
+
+        signed = t.encoding in (DW_ATE_signed, DW_ATE_signed_char)
+        val = int.from_bytes(data, order, signed=signed)
+
+        if t.encoding == DW_ATE_boolean:
+            return 'true' if val else 'false'
+
+        text = f'0x{val & ((1 << (t.size * 8)) - 1):0{t.size * 2}X}' \
+            if hex_ints else str(val)
+
+        if t.is_char and 0x20 <= (val & 0xFF) < 0x7F:
+            text += f" '{chr(val & 0xFF)}'"
+
+        return text
+
+    if isinstance(t, PointerType):
+        return f'0x{int.from_bytes(data, order):0{t.size * 2}X}'
+
+    if isinstance(t, EnumType):
+        val = int.from_bytes(data, order, signed=t.signed)
+
+        return t.values.get(val, str(val))
+
+    if isinstance(t, ArrayType):
+        e = t.element
+
+        # Arrays of char are shown as strings, but not those of (u)int8_t
+        if isinstance(e, BaseType) and e.is_char and 'char' in e.name:
+            return repr(data.split(b'\x00')[0].decode('latin-1'))
+
+        return '{' + ', '.join(
+            decode(e, data[i * e.size:(i + 1) * e.size], endian, hex_ints)
+            for i in range(t.count)
+        ) + '}'
+
+    if isinstance(t, StructType):
+        fields = []
+
+        for m in t.members:
+            if m.bit_size is not None:
+                nbytes = (m.bit_offset + m.bit_size + 7) // 8
+                val = bitfield(data[m.offset:m.offset + nbytes], m.bit_size,
+                               m.bit_offset, endian)
+                text = f'0x{val:X}' if hex_ints else str(val)
+            else:
+                text = decode(m.type, data[m.offset:m.offset + m.type.size],
+                              endian, hex_ints)
+
+            fields.append(f'{m.name} = {text}')
+
+        return '{' + ', '.join(fields) + '}'
+
+    return data.hex(' ')
+
+
+def format_item(item: Item, data: bytes, endian: str, hex_ints: bool) -> str:
+    if item.bit_size is not None:
+        val = bitfield(data, item.bit_size, item.bit_offset, endian)
+
+        return f'0x{val:X}' if hex_ints else str(val)
+
+    return decode(item.type, data, endian, hex_ints)
+
+
+def show(items: list, reads: list, data: dict, endian: str,
+         hex_ints: bool) -> None:
+    width = max(len(i.label) for i in items)
+
+    for item in items:
+        value = format_item(item, extract(item, reads, data), endian, hex_ints)
+        print(f'{item.label:{width}}  0x{item.addr:06X}  {value}')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Read program variables by name via the bootloader'
+    )
+    parser.add_argument(
+        'elf',
+        type=str,
+        help='ELF file of the program running on the target'
+    )
+    parser.add_argument(
+        'names',
+        type=str, nargs='*',
+        help='Variables to read, optionally followed by :type'
+    )
+    parser.add_argument(
+        '-p', '--port',
+        dest='port', type=str, default=DEV,
+        help=f'Serial device (default {DEV})'
+    )
+    parser.add_argument(
+        '--baud',
+        dest='baud', type=int, default=BAUD,
+        help=f'Baud rate (default {BAUD})'
+    )
+    parser.add_argument(
+        '-w', '--watch',
+        dest='watch_flag', action='store_true', default=False,
+        help='Read continuously, refreshing the display'
+    )
+    parser.add_argument(
+        '-i', '--interval',
+        dest='interval', type=float, default=0,
+        help='Minimum time in seconds between refreshes in watch mode '
+             '(default 0, as fast as the link allows)'
+    )
+    parser.add_argument(
+        '-g', '--max-gap',
+        dest='max_gap', type=int, default=None,
+        help='Largest number of unwanted bytes read to join two variables '
+             'into one read (default chosen from the link round trip time)'
+    )
+    parser.add_argument(
+        '-b', '--bytes',
+        dest='bytes_flag', action='store_true', default=False,
+        help='Read memory a byte at a time, rather than widening reads to '
+             'whole longs'
+    )
+    parser.add_argument(
+        '-x', '--hex',
+        dest='hex_flag', action='store_true', default=False,
+        help='Show integers in hex'
+    )
+    parser.add_argument(
+        '-v', '--verbose',
+        dest='verbose_flag', action='store_true', default=False,
+        help='Show the reads that are made'
+    )
+    parser.add_argument(
+        '-l', '--list',
+        dest='list_flag', action='store_true', default=False,
+        help='List the variables in the ELF file and exit'
+    )
+    args = parser.parse_intermixed_args()
+
+    symbols = Symbols(args.elf)
+
+    if args.list_flag:
+        for addr, size, type_name, name in symbols.listing():
+            print(f'0x{addr:06X}  {size:6}  {type_name:24}  {name}')
+
+        return 0
+
+    if len(args.names) == 0:
+        parser.error('No variables given')
+
+    items = [parse_item(name, symbols) for name in args.names]
+
+    link = BootloaderLink(args.port, args.baud)
+
+    if not link.ping():
+        print('Bootloader is not responding')
+
+        return 1
+
+    max_gap = args.max_gap
+
+    if max_gap is None:
+        # Bytes that could have been received in the time a separate command
+        # costs: its acknowledgement, and the part of the round trip that
+        # queueing does not hide
+        start = time.perf_counter()
+        link.ping(retries=1)
+        rtt = time.perf_counter() - start
+
+        max_gap = 1 + int(max(rtt * link.line_rate - 2, RW_HEADER_LEN))
+
+    reads = plan_reads(items, max_gap, 1 if args.bytes_flag else 4)
+    fetcher = Fetcher(link, reads)
+    total = sum(count * width for _, count, width in reads)
+
+    if args.verbose_flag:
+        print(f'Joining reads up to {max_gap} bytes apart', file=sys.stderr)
+
+        for addr, count, width in reads:
+            print(f'Read 0x{addr:06X} {count} x {width}', file=sys.stderr)
+
+    if not args.watch_flag:
+        show(items, reads, fetcher.fetch(), symbols.endian, args.hex_flag)
+        link.close()
+
+        return 0
+
+    passes = 0
+    rate = 0
+    window = time.perf_counter()
+
+    try:
+        while True:
+            start = time.perf_counter()
+            data = fetcher.fetch(more=args.interval == 0)
+            passes += 1
+
+            if start - window >= 1:
+                rate = passes / (start - window)
+                passes = 0
+                window = start
+
+            # Clear the screen and home the cursor
+            print('\x1b[H\x1b[J', end='')
+            print(f'{len(items)} variables, {len(reads)} reads, {total} bytes, '
+                  f'{rate:.1f} Hz ({rate * total / link.line_rate * 100:.0f}% '
+                  'of line)')
+            print()
+            show(items, reads, data, symbols.endian, args.hex_flag)
+            sys.stdout.flush()
+
+            remaining = args.interval - (time.perf_counter() - start)
+
+            if remaining > 0:
+                time.sleep(remaining)
+    except KeyboardInterrupt:
+        # A pass may have been interrupted with reads still outstanding
+        link.drain()
+
+    link.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (BootloaderError, ValueError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,96 @@
+/* Generated by dtgen.py from COMET68k.dts, do not edit. To regenerate:
+ *
+ *   python3 dtgen.py COMET68k.dts -o COMET68k.h
+ */
+
+#ifndef COMET68K_DT_H
+#define COMET68K_DT_H
+
+/* / */
+#define DT_MODEL                                 "COMET68k"
+
+/* /cpus */
+#define DT_CPUS_PATH                             "/cpus"
+
+/* /cpus/cpu@0 */
+#define DT_CPU0_PATH                             "/cpus/cpu@0"
+#define DT_CPU0_REG_ADDR                         0x00000000
+#define DT_CPU0_COMPATIBLE                       "motorola,68000"
+#define DT_CPU0_DEVICE_TYPE                      "cpu"
+#define DT_CPU0_CLOCK_FREQUENCY                  10000000
+
+/* /memory@0 */
+#define DT_MEMORY_0_PATH                         "/memory@0"
+#define DT_MEMORY_0_REG_ADDR                     0x00000000
+#define DT_MEMORY_0_REG_SIZE                     0x400000
+#define DT_MEMORY_0_DEVICE_TYPE                  "memory"
+
+/* /memory@f00000 */
+#define DT_ROM0_PATH                             "/memory@f00000"
+#define DT_ROM0_REG_ADDR                         0x00F00000
+#define DT_ROM0_REG_SIZE                         0x80000
+#define DT_ROM0_DEVICE_TYPE                      "flash"
+
+/* /memory@f80000 */
+#define DT_ROM1_PATH                             "/memory@f80000"
+#define DT_ROM1_REG_ADDR                         0x00F80000
+#define DT_ROM1_REG_SIZE                         0x80000
+#define DT_ROM1_DEVICE_TYPE                      "flash"
+
+/* /xbus@c00000 */
+#define DT_XBUS_C00000_PATH                      "/xbus@c00000"
+#define DT_XBUS_C00000_REG_ADDR                  0x00C00000
+#define DT_XBUS_C00000_REG_SIZE                  0x100000
+#define DT_XBUS_C00000_COMPATIBLE                "simple-bus"
+
+/* /xbus@c00000/gpio@c10000 */
+#define DT_CSR1_PATH                             "/xbus@c00000/gpio@c10000"
+#define DT_CSR1_REG_ADDR                         0x00C10000
+#define DT_CSR1_REG_SIZE                         0x1
+
+/* /xbus@c00000/gpio@c10001 */
+#define DT_CSR2_PATH                             "/xbus@c00000/gpio@c10001"
+#define DT_CSR2_REG_ADDR                         0x00C10001
+#define DT_CSR2_REG_SIZE                         0x1
+
+/* /xbus@c00000/serial@c20008 */
+#define DT_SERIAL0_PATH                          "/xbus@c00000/serial@c20008"
+#define DT_SERIAL0_REG_ADDR                      0x00C20008
+#define DT_SERIAL0_REG_SIZE                      0x8
+#define DT_SERIAL0_COMPATIBLE                    "ns16550"
+#define DT_SERIAL0_CLOCK_FREQUENCY               7372800
+#define DT_SERIAL0_IRQ                           5
+
+/* /xbus@c00000/serial@c20000 */
+#define DT_SERIAL1_PATH                          "/xbus@c00000/serial@c20000"
+#define DT_SERIAL1_REG_ADDR                      0x00C20000
+#define DT_SERIAL1_REG_SIZE                      0x8
+#define DT_SERIAL1_COMPATIBLE                    "ns16550"
+#define DT_SERIAL1_CLOCK_FREQUENCY               7372800
+#define DT_SERIAL1_IRQ                           5
+
+/* /xbus@c00000/timer@c30000 */
+#define DT_TIMER0_PATH                           "/xbus@c00000/timer@c30000"
+#define DT_TIMER0_REG_ADDR                       0x00C30000
+#define DT_TIMER0_REG_SIZE                       0x20
+#define DT_TIMER0_COMPATIBLE                     "dp8570a"
+#define DT_TIMER0_CLOCK_FREQUENCY                625000
+#define DT_TIMER0_IRQ                            1
+
+/* compatible = "motorola,68000" */
+#define DT_COMPAT_MOTOROLA_68000_COUNT           1
+#define DT_COMPAT_MOTOROLA_68000_FOREACH(fn)     fn(CPU0)
+
+/* compatible = "simple-bus" */
+#define DT_COMPAT_SIMPLE_BUS_COUNT               1
+#define DT_COMPAT_SIMPLE_BUS_FOREACH(fn)         fn(XBUS_C00000)
+
+/* compatible = "ns16550" */
+#define DT_COMPAT_NS16550_COUNT                  2
+#define DT_COMPAT_NS16550_FOREACH(fn)            fn(SERIAL0) fn(SERIAL1)
+
+/* compatible = "dp8570a" */
+#define DT_COMPAT_DP8570A_COUNT                  1
+#define DT_COMPAT_DP8570A_FOREACH(fn)            fn(TIMER0)
+
+#endif /* COMET68K_DT_H */
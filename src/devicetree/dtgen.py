@@ -0,0 +1,395 @@
+# Generate a header describing the hardware in a devicetree source file
+#
+# The on-board hardware of the COMET68k never changes, so looking it up in the
+# devicetree blob at run time gains nothing. This turns the devicetree source
+# into a header of #defines instead, so that code is compiled against the
+# addresses, clocks and interrupts given in COMET68k.dts, and the source stays
+# the one place where they are written down. The blob is still there for
+# anything that is not known when compiling, such as expansion cards.
+#
+#   python3 dtgen.py COMET68k.dts -o COMET68k.h
+#
+# Each node is named by its alias if it has one, or otherwise its label, or
+# otherwise its path, in upper case with anything other than letters and digits
+# replaced by _. For each node:
+#
+#   DT_<node>_PATH               full path, as a string
+#   DT_<node>_REG_ADDR           address and size of the first reg entry, and
+#   DT_<node>_REG_SIZE           of the others as DT_<node>_REG_<n>_ADDR etc
+#   DT_<node>_COMPATIBLE         first compatible string
+#   DT_<node>_<property>         any other property of a single cell, or a
+#                                single string, e.g. DT_SERIAL0_CLOCK_FREQUENCY
+#
+# Properties of the root node are given as DT_<property>, e.g. DT_MODEL. For
+# each compatible string:
+#
+#   DT_COMPAT_<compatible>_COUNT          number of nodes
+#   DT_COMPAT_<compatible>_FOREACH(fn)    fn(<node>) for each node
+#
+# Addresses are translated to CPU addresses through the ranges properties of
+# parent nodes. The values are plain #defines so that they can be used from C,
+# C++ (where they are constant expressions) and assembler alike.
+#
+# Only the devicetree source syntax used by COMET68k.dts is understood: nodes,
+# labels, cell lists, strings and comments. Includes, expressions, byte strings
+# and references are not.
+
+import argparse
+import os
+import re
+import sys
+
+TOKEN_RE = re.compile(r'''
+    (?P<space>\s+|/\*.*?\*/|//[^\n]*) |
+    (?P<string>"(?:[^"\\]|\\.)*") |
+    (?P<directive>/[a-z0-9-]+/) |
+    (?P<label>[A-Za-z_][\w]*:) |
+    (?P<word>[\w#?][\w,.+\-#@?]*) |
+    (?P<punct>[{}<>;=,/])
+''', re.VERBOSE | re.DOTALL)
+
+
+class DtsError(Exception):
+    pass
+
+
+class Node:
+    def __init__(self, name: str, parent=None):
+        self.name = name
+        self.parent = parent
+        self.labels = []
+        self.props = {}
+        self.children = []
+
+    @property
+    def path(self) -> str:
+        if self.parent is None:
+            return '/'
+
+        parent = self.parent.path
+
+        return f'{parent}{"" if parent == "/" else "/"}{self.name}'
+
+    def cells(self, name: str, default: int) -> int:
+        value = self.props.get(name)
+
+        return value[0] if isinstance(value, list) and value else default
+
+
+def tokenise(text: str) -> list:
+    tokens = []
+    pos = 0
+
+    while pos < len(text):
+        match = TOKEN_RE.match(text, pos)
+
+        if not match:
+            line = text.count('\n', 0, pos) + 1
+            raise DtsError(f'Cannot parse line {line}: {text[pos:pos + 20]!r}')
+
+        pos = match.end()
+
+        if match.lastgroup != 'space':
+            tokens.append((match.lastgroup, match.group()))
+
+    return tokens
+
+
+def parse(text: str) -> Node:
+    tokens = tokenise(text)
+    pos = 0
+
+    def take(kind: str = None, value: str = None) -> str:
+        nonlocal pos
+
+        if pos >= len(tokens):
+            raise DtsError('Unexpected end of file')
+
+        tok_kind, tok_value = tokens[pos]
+
+        if (kind and tok_kind != kind) or (value and tok_value != value):
+            raise DtsError(f'Expected {value or kind}, found {tok_value}')
+
+        pos += 1
+
+        return tok_value
+
+    def peek() -> tuple:
+        return tokens[pos] if pos < len(tokens) else (None, None)
+
+    def value() -> object:
+        """ A property value: a list of cells, or a list of strings """
+        if peek()[1] == '<':
+            take(value='<')
+            cells = []
+
+            while peek()[1] != '>':
+                word = take('word')
+
+                try:
+                    cells.append(int(word, 0) & 0xFFFFFFFF)
+                except ValueError:
+                    raise DtsError(f'Unsupported cell value {word}')
+
+            take(value='>')
+
+            if peek()[1] == ',':
+                raise DtsError('Lists of cell groups are not supported')
+
+            return cells
+
+        strings = []
+
+        while True:
+            strings.append(bytes(take('string')[1:-1], 'utf-8')
+                           .decode('unicode_escape'))
+
+            if peek()[1] != ',':
+                return strings
+
+            take(value=',')
+
+    def body(node: Node) -> None:
+        take(value='{')
+
+        while peek()[1] != '}':
+            labels = []
+
+            while peek()[0] == 'label':
+                labels.append(take()[:-1])
+
+            name = take('word')
+
+            if peek()[1] == '{':
+                child = Node(name, node)
+                child.labels = labels
+                node.children.append(child)
+                body(child)
+            elif peek()[1] == '=':
+                take(value='=')
+                node.props[name] = value()
+            else:
+                node.props[name] = True
+
+            take(value=';')
+
+        take(value='}')
+
+    root = None
+
+    while pos < len(tokens):
+        kind, tok = peek()
+
+        if kind == 'directive' and tok == '/dts-v1/':
+            take()
+            take(value=';')
+        elif tok == '/':
+            take()
+
+            if root is None:
+                root = Node('')
+
+            body(root)
+            take(value=';')
+        else:
+            raise DtsError(f'Unsupported syntax at {tok}')
+
+    if root is None:
+        raise DtsError('No root node')
+
+    return root
+
+
+def walk(node: Node):
+    yield node
+
+    for child in node.children:
+        yield from walk(child)
+
+
+def macro_name(name: str) -> str:
+    return re.sub(r'[^A-Z0-9]', '_', name.upper()).strip('_')
+
+
+def translate(node: Node, addr: int) -> int:
+    """ Translate an address on the bus of node's parent to a CPU address """
+    bus = node.parent
+
+    while bus is not None and bus.parent is not None:
+        ranges = bus.props.get('ranges')
+
+        if ranges is None or ranges is True:
+            # No ranges (as on a simple-bus giving CPU addresses), or empty
+            # ranges, both taken to mean the same addresses
+            bus = bus.parent
+            continue
+
+        child_cells = bus.cells('#address-cells', 2)
+        parent_cells = bus.parent.cells('#address-cells', 2)
+        size_cells = bus.cells('#size-cells', 1)
+        step = child_cells + parent_cells + size_cells
+
+        for pos in range(0, len(ranges), step):
+            child = join(ranges[pos:pos + child_cells])
+            parent = join(ranges[pos + child_cells:
+                                 pos + child_cells + parent_cells])
+            size = join(ranges[pos + child_cells + parent_cells:pos + step])
+
+            if child <= addr < child + size:
+                addr = addr - child + parent
+                break
+        else:
+            raise DtsError(f'{node.path}: address {addr:#x} is outside the '
+                           f'ranges of {bus.path}')
+
+        bus = bus.parent
+
+    return addr
+
+
+def join(cells: list) -> int:
+    val = 0
+
+    for cell in cells:
+        val = (val << 32) | cell
+
+    return val
+
+
+def generate(root: Node, source: str) -> str:
+    aliases = {}
+
+    for node in root.children:
+        if node.name == 'aliases':
+            for alias, target in node.props.items():
+                if isinstance(target, list) and target and \
+                        isinstance(target[0], str):
+                    aliases.setdefault(target[0], alias)
+
+    lines = [
+        f'/* Generated by dtgen.py from {source}, do not edit. To regenerate:',
+        ' *',
+        f' *   python3 dtgen.py {source} -o {os.path.splitext(source)[0]}.h',
+        ' */',
+        '',
+        f'#ifndef {macro_name(os.path.splitext(source)[0])}_DT_H',
+        f'#define {macro_name(os.path.splitext(source)[0])}_DT_H',
+    ]
+    compatibles = {}
+    names = set()
+
+    for node in walk(root):
+        if node.name in ('aliases', 'chosen'):
+            continue
+
+        if node is root:
+            name = ''
+        elif node.path in aliases:
+            name = macro_name(aliases[node.path])
+        elif node.labels:
+            name = macro_name(node.labels[0])
+        else:
+            name = macro_name(node.path)
+
+        if name in names:
+            raise DtsError(f'{node.path}: name {name} is used twice')
+
+        names.add(name)
+        prefix = f'DT_{name}' if name else 'DT'
+        defs = [(f'{prefix}_PATH', f'"{node.path}"')] if name else []
+
+        reg = node.props.get('reg')
+
+        if isinstance(reg, list):
+            addr_cells = node.parent.cells('#address-cells', 2)
+            size_cells = node.parent.cells('#size-cells', 1)
+            step = addr_cells + size_cells
+
+            for num, pos in enumerate(range(0, len(reg), step)):
+                addr = translate(node, join(reg[pos:pos + addr_cells]))
+                entry = '' if num == 0 else f'_{num}'
+                defs.append((f'{prefix}_REG{entry}_ADDR', f'0x{addr:08X}'))
+
+                if size_cells:
+                    size = join(reg[pos + addr_cells:pos + step])
+                    defs.append((f'{prefix}_REG{entry}_SIZE', f'0x{size:X}'))
+
+        compat = node.props.get('compatible')
+
+        if isinstance(compat, list) and compat and isinstance(compat[0], str):
+            defs.append((f'{prefix}_COMPATIBLE', f'"{compat[0]}"'))
+
+            for string in compat:
+                compatibles.setdefault(string, []).append(name)
+
+        for prop, val in node.props.items():
+            if prop in ('reg', 'compatible') or prop.startswith('#'):
+                continue
+
+            if isinstance(val, list) and len(val) == 1:
+                if isinstance(val[0], int):
+                    defs.append((f'{prefix}_{macro_name(prop)}', str(val[0])))
+                else:
+                    defs.append((f'{prefix}_{macro_name(prop)}',
+                                 f'"{val[0]}"'))
+
+        lines.append('')
+        lines.append(f'/* {node.path} */')
+
+        for macro, val in defs:
+            lines.append(f'#define {macro:40} {val}')
+
+    for string, nodes in compatibles.items():
+        prefix = f'DT_COMPAT_{macro_name(string)}'
+        foreach = ' '.join(f'fn({n})' for n in nodes)
+
+        lines.append('')
+        lines.append(f'/* compatible = "{string}" */')
+        lines.append(f'#define {prefix + "_COUNT":40} {len(nodes)}')
+        lines.append(f'#define {prefix + "_FOREACH(fn)":40} {foreach}')
+
+    lines += [
+        '',
+        f'#endif /* {macro_name(os.path.splitext(source)[0])}_DT_H */',
+        '',
+    ]
+
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate a header of #defines from a devicetree source'
+    )
+    parser.add_argument(
+        'dts',
+        type=str,
+        help='Devicetree source, e.g. COMET68k.dts'
+    )
+    parser.add_argument(
+        '-o', '--output',
+        dest='output', type=str, default=None,
+        help='Filename of output header (default: written to stdout)'
+    )
+    args = parser.parse_args()
+
+    with open(args.dts, 'r') as f:
+        root = parse(f.read())
+
+    header = generate(root, os.path.basename(args.dts))
+
+    if args.output is None:
+        print(header, end='')
+    else:
+        with open(args.output, 'w') as f:
+            f.write(header)
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (DtsError, OSError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
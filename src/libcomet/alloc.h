@@ -0,0 +1,77 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Memory allocation
+ *
+ * heap_alloc() and heap_free() manage the .heap region reserved by platform.ld
+ * (_heap_start to _heap_end) with a TLSF (two level segregated fit) allocator.
+ * Free blocks are kept in lists by size class, with a bitmap of which lists
+ * are not empty, so both allocating and freeing take the same time however
+ * many blocks there are.
+ *
+ * Pools hand out blocks of one fixed size, e.g. for packet or sector buffers,
+ * from a free list. Their memory can come from the heap (pool_create()) or be
+ * provided by the program (pool_init()).
+ *
+ * heap_init() is called by crt0 before any constructors, in programs which use
+ * the heap. A heap of less than 24 bytes, too small for one block, is left
+ * empty, and heap_alloc() always returns NULL. All other functions may be called from interrupt handlers.
+ * Interrupts are masked while the free lists are changed. */
+
+/* Statistics kept by the heap and by each pool. For the heap, used and high are
+ * in bytes (including block headers), and for a pool in blocks. */
+struct alloc_stats {
+    uint32_t used;                  /* In use now */
+    uint32_t high;                  /* Most ever in use */
+    uint32_t allocs;                /* Successful allocations */
+    uint32_t frees;
+    uint32_t fails;                 /* Allocations that could not be met */
+    uint32_t rate;                  /* Allocations per alloc_tick() period */
+    uint32_t last;                  /* allocs at the last alloc_tick() */
+};
+
+/* Fragmentation of the heap, from heap_usage() */
+struct heap_usage {
+    uint32_t size;                  /* Total size of the heap */
+    uint32_t free;                  /* Bytes free */
+    uint32_t largest;               /* Size of the largest free block */
+    uint16_t free_blocks;           /* Number of free blocks */
+    uint16_t fragmentation;         /* Percentage of free space not in the
+                                     * largest free block */
+};
+
+struct pool {
+    void *free;                     /* Free blocks, linked through their
+                                     * first long */
+    uint16_t size;                  /* Size of each block */
+    uint16_t count;                 /* Number of blocks */
+    struct alloc_stats stats;
+};
+
+extern struct alloc_stats heap_stats;
+
+void heap_init(void);
+void *heap_alloc(uint32_t size);
+void heap_free(void *ptr);
+void heap_usage(struct heap_usage *usage);
+
+void pool_init(struct pool *pool, void *mem, uint16_t size, uint16_t count);
+int pool_create(struct pool *pool, uint16_t size, uint16_t count);
+void *pool_alloc(struct pool *pool);
+void pool_free(struct pool *pool, void *block);
+
+/* Call at a fixed interval, e.g. once a second from a timer interrupt, to have
+ * the rate member of stats count allocations per interval */
+void alloc_tick(struct alloc_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALLOC_H */
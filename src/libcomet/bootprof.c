@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include "DP8570A.h"
+#include "cpu.h"
+#include "bootprof.h"
+#include "console.h"
+
+/* Functions used before a compressed image has been decompressed are placed
+ * where platform_z.ld keeps them in ROM */
+#define BOOTTEXT __attribute__((section(".text.bootprof")))
+
+struct bootprof bootprof __attribute__((section(".bootprof")));
+
+static const char *const stage_names[] = {
+    "", "dram", "unpack", "vectors", "bss", "data", "ctors", "devicetree",
+    "drivers", "ready"
+};
+
+#define STAGE_NAMES (sizeof(stage_names) / sizeof(stage_names[0]))
+
+BOOTTEXT void
+bootprof_init(void)
+{
+    /* The timer is only used for its count, so make sure it cannot
+     * interrupt */
+    TMSR = TIMER_MSR_RS;
+    TICR0 &= ~TIMER_ICR0_T0;
+    TMSR = 0;
+
+    bootprof.hz = BOOTPROF_HZ;
+    bootprof.count = 0;
+    bootprof.max = BOOTPROF_MAX;
+    bootprof.wraps = 0;
+    bootprof.magic = BOOTPROF_MAGIC;
+}
+
+BOOTTEXT uint32_t
+bootprof_now(void)
+{
+    uint16_t count;
+    uint16_t sr;
+    uint32_t wraps;
+
+    sr = irq_save();
+
+    /* Latch the count. It is reset when the LSB is read. */
+    TT0CR = TIMER_TCR_RD | TIMER_TCR_CLK_EXT | TIMER_TCR_MODE1 | TIMER_TCR_TSS;
+    count = TT0MSB << 8;
+    count |= TT0LSB;
+
+    /* The timer counts down from 0xFFFF, and flags each time it reaches
+     * zero */
+    count = 0xFFFF - count;
+    wraps = bootprof.wraps;
+
+    if (TMSR & TIMER_MSR_T0) {
+        TMSR = TIMER_MSR_T0;
+        bootprof.wraps++;
+
+        /* If the count was read just before reaching zero, the wrap belongs
+         * after it */
+        if (count < 0x8000) {
+            wraps++;
+        }
+    }
+
+    irq_restore(sr);
+
+    return ((wraps << 16) | count) & 0xFFFFFF;
+}
+
+BOOTTEXT void
+bootprof_mark(uint8_t stage)
+{
+    uint32_t now;
+
+    if (bootprof.magic != BOOTPROF_MAGIC) {
+        return;
+    }
+
+    now = bootprof_now();
+
+    if (bootprof.count < bootprof.max) {
+        bootprof.rec[bootprof.count++] = ((uint32_t)stage << 24) | now;
+    }
+}
+
+uint32_t
+bootprof_us(uint32_t ticks)
+{
+    uint16_t high = ticks >> 16;
+
+    /* Each tick is 1.6us, and 0.6 is close to 39322 / 65536 (the result is
+     * high by 4 parts in a million). The multiplications are 16 by 16 bits,
+     * which the 68000 does in one instruction. */
+    return ticks + (uint32_t)high * (uint16_t)39322 +
+        (((uint32_t)(uint16_t)ticks * (uint16_t)39322) >> 16);
+}
+
+void
+bootprof_print(void)
+{
+    char name[12];
+    uint32_t last = 0;
+    uint32_t rec;
+    uint32_t us;
+    uint8_t stage;
+    uint8_t ctr;
+
+    if (bootprof.magic != BOOTPROF_MAGIC) {
+        console_puts("No boot profile\r\n", 0);
+
+        return;
+    }
+
+    console_puts("stage          at us   took us\r\n", 0);
+
+    for (ctr = 0; ctr < bootprof.count; ctr++) {
+        rec = bootprof.rec[ctr];
+        stage = rec >> 24;
+        us = bootprof_us(rec & 0xFFFFFF);
+
+        if (stage < STAGE_NAMES && stage_names[stage][0]) {
+            console_puts(stage_names[stage], 12);
+        } else {
+            console_puts("stage ", 0);
+            format_dec(name, stage);
+            console_puts(name, 6);
+        }
+
+        console_putdec(us, 8);
+        console_putdec(us - last, 10);
+        console_puts("\r\n", 0);
+
+        last = us;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef BOOTPROF_H
+#define BOOTPROF_H
+
+/* Start up profiling
+ *
+ * When built with make BOOT_PROFILE=1 (it is off by default), which defines
+ * BOOT_PROFILE for crt0.S, timer 0 of the DP8570A is started at reset, counting
+ * the 625kHz clock from the CPLD, and a timestamp is recorded as each stage of
+ * start up finishes: the DRAM start-up delay, decompression, the vector copy,
+ * clearing .bss, copying .data and running constructors. Programs record their
+ * own stages, such as devicetree lookups and driver initialisation, with
+ * bootprof_mark().
+ *
+ * The records are kept in the .bootprof section, which platform.ld places at
+ * the start of RAM and which is neither loaded nor cleared. bootprof.py (in
+ * COMET68k_bootloader) reads them through the bootloader, and
+ * bootprof_print() writes them to UART channel A.
+ *
+ * Timestamps are in ticks of 1.6us from reset, and are 24 bits long, so wrap
+ * after 26.8 seconds. The timer itself wraps every 65536 ticks (105ms), which
+ * is noticed the next time it is read, so a stage longer than that must call
+ * bootprof_now() at least once every 105ms to be timed correctly. */
+
+#define BOOTPROF_MAGIC 0x42505246   /* "BPRF" */
+#define BOOTPROF_MAX 16             /* Records kept */
+#define BOOTPROF_HZ 625000
+
+/* Stages of start up. Each record is the time at which the stage finished. */
+#define BOOTPROF_DRAM 1             /* DRAM start-up delay */
+#define BOOTPROF_UNPACK 2           /* Decompressing the image (platform_z.ld) */
+#define BOOTPROF_VECTORS 3          /* Copying the vector table to RAM */
+#define BOOTPROF_BSS 4              /* Clearing .bss */
+#define BOOTPROF_DATA 5             /* Copying .fasttext and .data */
+#define BOOTPROF_CTORS 6            /* Constructors, after which main() runs */
+#define BOOTPROF_DT 7               /* Devicetree lookups */
+#define BOOTPROF_DRIVERS 8          /* Driver initialisation */
+#define BOOTPROF_READY 9            /* Start up complete */
+#define BOOTPROF_USER 16            /* First of the program's own stages */
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct bootprof {
+    uint32_t magic;                 /* BOOTPROF_MAGIC once started */
+    uint32_t hz;                    /* Rate of timestamps */
+    uint8_t count;                  /* Records made */
+    uint8_t max;                    /* Records there is room for */
+    uint16_t wraps;                 /* Times the timer has counted down */
+    uint32_t rec[BOOTPROF_MAX];     /* Stage in the top 8 bits, and timestamp
+                                     * in the low 24 */
+};
+
+extern struct bootprof bootprof;
+
+/* Called by crt0.S once DRAM can be used, with the timer already started */
+void bootprof_init(void);
+
+/* Record that the given stage has finished. Does nothing once all records are
+ * used, or if crt0.S did not start the profile. */
+void bootprof_mark(uint8_t stage);
+
+/* Ticks since reset */
+uint32_t bootprof_now(void);
+
+/* Convert ticks to microseconds, without a division */
+uint32_t bootprof_us(uint32_t ticks);
+
+/* Write the profile to UART channel A, which must already be set up */
+void bootprof_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* BOOTPROF_H */
@@ -0,0 +1,175 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <libfdt.h>
+#include "alloc.h"
+#include "cards.h"
+#include "probe.h"
+
+/* Room for the longer name of a card's node in its overlay */
+#define NAME_ROOM 16
+
+/* The CF card's control/status register, and the printer card's control
+ * register. Reading the printer card's status register would clear its
+ * interrupt. */
+const struct card_type card_types[] = {
+    { "cf", "cf_interface_v2.dtbo", 0x0000, 0x3000, 0x20 },
+    { "printer", "printer_interface.dtbo", 0x4000, 0x7000, 0x02 },
+    { NULL, NULL, 0, 0, 0 }
+};
+
+/* Probe each window of a base, adding the cards found to found[*count] */
+static void
+probe_base(uint32_t base, struct card *found, int max, int *count)
+{
+    const struct card_type *type;
+    const volatile void *reg;
+    uint32_t offset;
+    uint8_t val;
+
+    for (type = card_types; type->name; type++) {
+        for (offset = type->first; offset <= type->last;
+             offset += CARDS_WINDOW_SIZE) {
+            reg = (const volatile void *)(uintptr_t)(base + offset +
+                                                      type->reg);
+
+            if (*count == max || probe_read8(reg, &val) < 0) {
+                continue;
+            }
+
+            found[*count].type = type;
+            found[*count].addr = base + offset;
+            (*count)++;
+        }
+    }
+}
+
+int
+cards_probe(const uint32_t *bases, int count, struct card *found, int max)
+{
+    uint32_t base;
+    int total = 0;
+    int ctr;
+
+    if (bases) {
+        for (ctr = 0; ctr < count; ctr++) {
+            probe_base(bases[ctr], found, max, &total);
+        }
+
+        return total;
+    }
+
+    for (base = CARDS_SPACE_START; base < CARDS_SPACE_END;
+         base += CARDS_BASE_SIZE) {
+        if (base == CARDS_ONBOARD_START) {
+            base = CARDS_ONBOARD_END;
+        }
+
+        probe_base(base, found, max, &total);
+    }
+
+    return total;
+}
+
+/* Name the node after the card's address, e.g. "cf@400000" */
+static int
+place_node(void *overlay, int node, uint32_t addr)
+{
+    static const char hex[] = "0123456789abcdef";
+    char name[64];
+    const char *old;
+    fdt32_t reg = cpu_to_fdt32(addr);
+    int len;
+    int shift;
+    int err;
+
+    err = fdt_setprop_inplace_namelen_partial(overlay, node, "reg", 3, 0,
+                                              &reg, sizeof(reg));
+
+    if (err) {
+        return err;
+    }
+
+    old = fdt_get_name(overlay, node, &len);
+
+    if (old == NULL) {
+        return len;
+    }
+
+    for (len = 0; old[len] && old[len] != '@'; len++) {
+        if (len == sizeof(name) - 10) {
+            return -FDT_ERR_BADVALUE;
+        }
+
+        name[len] = old[len];
+    }
+
+    name[len++] = '@';
+
+    for (shift = 28; shift > 0 && (addr >> shift) == 0; shift -= 4);
+
+    for (; shift >= 0; shift -= 4) {
+        name[len++] = hex[(addr >> shift) & 0xF];
+    }
+
+    name[len] = '\0';
+
+    return fdt_set_name(overlay, node, name);
+}
+
+static int
+apply_overlay(void *fdt, const void *rom, uint32_t len, uint32_t addr)
+{
+    void *overlay;
+    int node;
+    int err;
+
+    /* fdt_overlay_apply() changes the overlay as well as the tree */
+    overlay = heap_alloc(len + NAME_ROOM);
+
+    if (overlay == NULL) {
+        return -FDT_ERR_NOSPACE;
+    }
+
+    err = fdt_open_into(rom, overlay, len + NAME_ROOM);
+
+    for (node = 0; err == 0 && node >= 0;
+         node = fdt_next_node(overlay, node, NULL)) {
+        if (fdt_getprop(overlay, node, "reg", NULL)) {
+            err = place_node(overlay, node, addr);
+            break;
+        }
+    }
+
+    if (err == 0) {
+        err = fdt_overlay_apply(fdt, overlay);
+    }
+
+    heap_free(overlay);
+
+    return err;
+}
+
+int
+cards_apply_overlays(void *buf, int bufsize, const void *fdt,
+                     const struct romfs *fs, const struct card *cards,
+                     int count)
+{
+    const void *overlay;
+    uint32_t len;
+    int ctr;
+    int err;
+
+    err = fdt_open_into(fdt, buf, bufsize);
+
+    for (ctr = 0; err == 0 && ctr < count; ctr++) {
+        overlay = romfs_file(fs, cards[ctr].type->overlay, &len);
+
+        if (overlay == NULL) {
+            return -FDT_ERR_NOTFOUND;
+        }
+
+        err = apply_overlay(buf, overlay, len, cards[ctr].addr);
+    }
+
+    return err;
+}
@@ -0,0 +1,74 @@
+#ifndef CARDS_H
+#define CARDS_H
+
+#include <stdint.h>
+#include "romfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* COMETbus expansion cards
+ *
+ * COMET68k.dts only describes the CPU board. Cards in the backplane are found
+ * at start up by reading a register in each window a card may be set to, with
+ * probe.h catching the bus error of an empty window. Each card answers in a
+ * 4KB window: SW1 on the card selects a 64KB base, and J2 one of the windows
+ * within it, which are different for each type of card. So the window a card
+ * answers in also tells what it is.
+ *
+ * For each card found, cards_apply_overlays() applies the card's devicetree
+ * overlay from a romfs filesystem to a copy of the devicetree in RAM, placing
+ * the card's node at the address it was found at. Drivers then find every
+ * card in that one tree. See README.md. */
+
+/* Expansion bus address space, less the on-board I/O in 0xC00000-0xC4FFFF */
+#define CARDS_SPACE_START 0x400000
+#define CARDS_SPACE_END 0xF00000
+#define CARDS_ONBOARD_START 0xC00000
+#define CARDS_ONBOARD_END 0xC50000
+
+#define CARDS_BASE_SIZE 0x10000     /* Selected by SW1 */
+#define CARDS_WINDOW_SIZE 0x1000    /* Selected by J2 */
+
+struct card_type {
+    const char *name;
+    const char *overlay;            /* Name of its overlay in romfs */
+    uint16_t first;                 /* Offsets of the first and last windows */
+    uint16_t last;                  /* within a base it can be set to */
+    uint16_t reg;                   /* Offset of a byte register that can be
+                                     * read without side effects */
+};
+
+struct card {
+    const struct card_type *type;
+    uint32_t addr;                  /* Address of its window */
+};
+
+/* Known types of card, ending with one whose name is NULL */
+extern const struct card_type card_types[];
+
+/* Look for cards of every known type at each of count bases, or at every
+ * base in the expansion bus address space if bases is NULL. Stores up to max
+ * cards found, stopping once there are max, and returns the number stored.
+ * Each empty window costs a bus error, about 40us in all, so every window of
+ * every base takes about 55ms; a system whose cards are always set to the
+ * same few bases should list them. */
+int cards_probe(const uint32_t *bases, int count, struct card *found, int max);
+
+/* Copy the devicetree blob fdt into buf, of bufsize bytes, and apply the
+ * overlay of each of count cards from the filesystem fs. The first node with
+ * a reg property in each overlay is moved to the card's address. Returns 0, or
+ * a libfdt error, e.g. -FDT_ERR_NOTFOUND if a card has no overlay in fs or
+ * -FDT_ERR_NOSPACE if buf is too small. The tree in buf is not usable after an
+ * error, and must be copied again. Overlays are copied to the heap while
+ * they are applied. */
+int cards_apply_overlays(void *buf, int bufsize, const void *fdt,
+                         const struct romfs *fs, const struct card *cards,
+                         int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CARDS_H */
@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include "TL16C2552.h"
+#include "console.h"
+
+void
+console_putc(char c)
+{
+    while (UALSRbits.THRE == 0);
+
+    UATHR = c;
+}
+
+void
+console_puts(const char *str, uint8_t width)
+{
+    for (; *str; width -= (width > 0)) {
+        console_putc(*str++);
+    }
+
+    for (; width > 0; width--) {
+        console_putc(' ');
+    }
+}
+
+void
+console_putdec(uint32_t val, uint8_t width)
+{
+    char buf[11];
+    uint8_t len = format_dec(buf, val);
+
+    for (; len < width; len++) {
+        console_putc(' ');
+    }
+
+    console_puts(buf, 0);
+}
+
+uint8_t
+format_dec(char *buf, uint32_t val)
+{
+    static const uint32_t powers[] = {
+        1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100,
+        10, 1
+    };
+    char *p = buf;
+    uint8_t ctr;
+    char digit;
+
+    for (ctr = 0; ctr < 10; ctr++) {
+        digit = '0';
+
+        while (val >= powers[ctr]) {
+            val -= powers[ctr];
+            digit++;
+        }
+
+        if (digit != '0' || p != buf || ctr == 9) {
+            *p++ = digit;
+        }
+    }
+
+    *p = '\0';
+
+    return p - buf;
+}
@@ -0,0 +1,32 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Polled output to UART channel A, for reports such as bootprof_print() and
+ * drivers_print(). Each character waits for the transmitter to be empty, so
+ * these work without interrupts, but any LOG() records should be sent with
+ * log_flush() first. Padding is with spaces, and a width of 0 adds none. */
+
+void console_putc(char c);
+
+/* Left aligned in width characters */
+void console_puts(const char *str, uint8_t width);
+
+/* In decimal, right aligned in width characters */
+void console_putdec(uint32_t val, uint8_t width);
+
+/* Format val in decimal into buf, which must hold 11 characters, returning
+ * the number of digits. The 68000 has no 32 bit division, so each digit is
+ * found by subtracting powers of 10. */
+uint8_t format_dec(char *buf, uint32_t val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_H */
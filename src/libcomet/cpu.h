@@ -0,0 +1,49 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+/* Raise the interrupt mask to level 7, returning the previous contents of the
+ * status register so that they can be restored with irq_restore() */
+static inline uint16_t
+irq_save(void)
+{
+    uint16_t sr;
+
+    __asm__ volatile (
+        "move.w %%sr, %0\n\t"
+        "ori.w  #0x0700, %%sr"
+        : "=d" (sr)
+        :
+        : "memory", "cc"
+    );
+
+    return sr;
+}
+
+static inline void
+irq_restore(uint16_t sr)
+{
+    __asm__ volatile (
+        "move.w %0, %%sr"
+        :
+        : "d" (sr)
+        : "memory", "cc"
+    );
+}
+
+/* The current interrupt mask, 0 to 7 */
+static inline uint8_t
+irq_mask(void)
+{
+    uint16_t sr;
+
+    __asm__ volatile (
+        "move.w %%sr, %0"
+        : "=d" (sr)
+    );
+
+    return (sr >> 8) & 7;
+}
+
+#endif /* CPU_H */
@@ -0,0 +1,19 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CRC32, the same as zlib's crc32() and Python's zlib.crc32(). Start with crc
+ * 0, and pass the result back in to continue over more data. Uses a 1KB table
+ * in ROM, to look up a byte at a time. */
+uint32_t crc32(uint32_t crc, const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H */
@@ -0,0 +1,105 @@
+/* Run time support for freestanding C++, built without exceptions or RTTI
+ *
+ * new and delete use the heap (see alloc.h). Since exceptions are not
+ * available, new masks interrupts and stops if there is not enough memory
+ * rather than throwing std::bad_alloc. The nothrow forms return nullptr as
+ * usual. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "alloc.h"
+#include "cpu.h"
+
+/* From <new>, which a freestanding toolchain may not have */
+namespace std {
+    struct nothrow_t;
+}
+
+static void *
+cxx_alloc(size_t size)
+{
+    void *ptr = heap_alloc(size ? size : 1);
+
+    if (ptr == nullptr) {
+        irq_save();
+
+        for (;;);
+    }
+
+    return ptr;
+}
+
+void *
+operator new(size_t size)
+{
+    return cxx_alloc(size);
+}
+
+void *
+operator new[](size_t size)
+{
+    return cxx_alloc(size);
+}
+
+void *
+operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return heap_alloc(size ? size : 1);
+}
+
+void *
+operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return heap_alloc(size ? size : 1);
+}
+
+void
+operator delete(void *ptr) noexcept
+{
+    heap_free(ptr);
+}
+
+void
+operator delete[](void *ptr) noexcept
+{
+    heap_free(ptr);
+}
+
+void
+operator delete(void *ptr, size_t) noexcept
+{
+    heap_free(ptr);
+}
+
+void
+operator delete[](void *ptr, size_t) noexcept
+{
+    heap_free(ptr);
+}
+
+extern "C" {
+
+/* Static objects with destructors register them with __cxa_atexit(). main()
+ * never returns, so they are never called and need not be recorded. */
+void *__dso_handle = nullptr;
+
+int
+__cxa_atexit(void (*func)(void *), void *arg, void *dso)
+{
+    (void)func;
+    (void)arg;
+    (void)dso;
+
+    return 0;
+}
+
+/* Called if a pure virtual function is somehow called */
+void
+__cxa_pure_virtual(void)
+{
+    irq_save();
+
+    for (;;);
+}
+
+}
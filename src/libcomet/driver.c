@@ -0,0 +1,110 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <libfdt.h>
+#include "bootprof.h"
+#include "console.h"
+#include "driver.h"
+
+/* Find the driver for the first of a node's compatible strings that any
+ * driver handles, setting *matched to that string */
+static const struct dt_driver *
+match(const char *compat, int len, const char **matched)
+{
+    const struct dt_driver *drv;
+    const char *const *str;
+    const char *end = compat + len;
+
+    if (len <= 0 || end[-1] != '\0') {
+        return NULL;
+    }
+
+    for (; compat < end; compat += strlen(compat) + 1) {
+        for (drv = __dt_drivers_start; drv < __dt_drivers_end; drv++) {
+            for (str = drv->compatible; *str; str++) {
+                if (strcmp(*str, compat) == 0) {
+                    *matched = compat;
+
+                    return drv;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static int
+enabled(const void *fdt, int node)
+{
+    const char *status = fdt_getprop(fdt, node, "status", NULL);
+
+    return status == NULL || strcmp(status, "okay") == 0 ||
+        strcmp(status, "ok") == 0;
+}
+
+int
+drivers_probe(const void *fdt)
+{
+    const struct dt_driver *drv;
+    const char *compat;
+    const char *matched;
+    uint32_t start;
+    int probed = 0;
+    int node;
+    int len;
+    int err;
+
+    err = fdt_check_header(fdt);
+
+    if (err) {
+        return err;
+    }
+
+    for (node = 0; node >= 0; node = fdt_next_node(fdt, node, NULL)) {
+        compat = fdt_getprop(fdt, node, "compatible", &len);
+
+        if (compat == NULL || !enabled(fdt, node)) {
+            continue;
+        }
+
+        drv = match(compat, len, &matched);
+
+        if (drv == NULL) {
+            continue;
+        }
+
+        start = bootprof_now();
+        err = drv->probe(fdt, node, matched);
+        drv->stats->ticks += (bootprof_now() - start) & 0xFFFFFF;
+        drv->stats->probed++;
+
+        if (err < 0) {
+            drv->stats->failed++;
+        }
+
+        probed++;
+    }
+
+    if (node != -FDT_ERR_NOTFOUND) {
+        return node;
+    }
+
+    return probed;
+}
+
+void
+drivers_print(void)
+{
+    const struct dt_driver *drv;
+
+    console_puts("driver        nodes  failed       us\r\n", 0);
+
+    for (drv = __dt_drivers_start; drv < __dt_drivers_end; drv++) {
+        console_puts(drv->name, 12);
+        console_putdec(drv->stats->probed, 7);
+        console_putdec(drv->stats->failed, 8);
+        console_putdec(bootprof_us(drv->stats->ticks), 9);
+        console_puts("\r\n", 0);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Devicetree driver binding
+ *
+ * Rather than each driver looking for its nodes with
+ * fdt_node_offset_by_compatible(), which walks the whole tree every time,
+ * drivers declare the compatible strings they handle with DT_DRIVER():
+ *
+ *   static const char *const uart_compat[] = { "ns16550", NULL };
+ *   DT_DRIVER(uart, uart_compat, uart_probe);
+ *
+ * DT_DRIVER() places an entry in the .dt_drivers section, which platform.ld
+ * collects into a table, so linking a driver in is all it takes to register
+ * it. drivers_probe() then walks the tree once, and calls the probe function
+ * of the driver for each node it matches. The time each driver's probe
+ * function takes is added up, and drivers_print() writes it out.
+ *
+ * A node is matched on the first of its compatible strings that any driver
+ * handles, so the most specific driver linked in is used, and only one driver
+ * probes each node. Nodes whose status is not "okay" are skipped. */
+
+struct driver_stats {
+    uint16_t probed;                /* Nodes probed */
+    uint16_t failed;                /* Probes returning an error */
+    uint32_t ticks;                 /* Time spent probing, in bootprof_now()
+                                     * ticks */
+};
+
+struct dt_driver {
+    const char *name;
+    const char *const *compatible;  /* Ending with NULL */
+
+    /* Called with the node and the compatible string it was matched on.
+     * Returns 0, or a negative error. */
+    int (*probe)(const void *fdt, int node, const char *compatible);
+
+    struct driver_stats *stats;
+};
+
+#define DT_DRIVER(name_, compatible_, probe_)                                 \
+    static struct driver_stats __dt_stats_##name_;                            \
+    static const struct dt_driver __dt_driver_##name_                         \
+        __attribute__((section(".dt_drivers"), used, aligned(4))) = {         \
+        #name_, compatible_, probe_, &__dt_stats_##name_                      \
+    }
+
+/* The table of drivers, from platform.ld */
+extern const struct dt_driver __dt_drivers_start[];
+extern const struct dt_driver __dt_drivers_end[];
+
+/* Probe every node of the tree that a driver is linked in for. Returns the
+ * number of nodes probed, including those whose probe failed, or a libfdt
+ * error if the tree is not valid. */
+int drivers_probe(const void *fdt);
+
+/* Write the number of nodes and time taken by each driver to UART channel A,
+ * which must already be set up */
+void drivers_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVER_H */
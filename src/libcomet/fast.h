@@ -0,0 +1,18 @@
+#ifndef FAST_H
+#define FAST_H
+
+/* Functions marked FASTTEXT are linked to run from DRAM. They are stored in ROM
+ * and copied to DRAM by crt0.S at start up, along with .data. Each instruction
+ * fetch from ROM takes two 8 bit reads plus wait states, so this suits
+ * interrupt handlers and inner loops.
+ *
+ * noinline keeps the function in its own section rather than having it copied
+ * into callers that are in ROM. */
+#define FASTTEXT __attribute__((section(".fasttext"), noinline))
+
+/* Read only tables that are accessed often can be marked FASTDATA to be copied
+ * to DRAM in the same way. Only const data may be marked FASTDATA, since other
+ * initialised data is in DRAM already. */
+#define FASTDATA __attribute__((section(".fastdata")))
+
+#endif /* FAST_H */
@@ -0,0 +1,485 @@
+#ifndef FDT_HPP
+#define FDT_HPP
+
+#include <stdint.h>
+#include <libfdt.h>
+
+/* Devicetree properties for C++
+ *
+ * Typed views of a blob, over libfdt, which point into the blob rather than
+ * copying anything out of it. A property of cells is a range of them, loaded
+ * as each is used, and a reg property a range of (address, size) pairs:
+ *
+ *   fdt::node dev(blob, offset);
+ *   fdt::bus bus(dev.parent());
+ *
+ *   for (auto r : dev.reg(bus)) { ... r.address ... r.size ... }
+ *   uint32_t clock = dev.u32("clock-frequency", 0);
+ *
+ * A bus looks up #address-cells and #size-cells of its node once, when it is
+ * made, so every reg property of the nodes on it is read with no further
+ * lookups. Lengths are checked once, when a view is made: a property that is
+ * too short for what is asked of it gives an empty view. With the cells in
+ * native byte order (see libfdt/README.md), each cell read is a single load
+ * from the blob.
+ *
+ * Subnodes and properties can be iterated over too:
+ *
+ *   for (auto child : dev.subnodes()) { ... child.name() ... }
+ *   for (auto prop : dev.properties()) { ... prop.name() ... }
+ *
+ * Nothing is allocated, and views are only valid while the blob is unchanged.
+ */
+
+namespace fdt {
+
+/* Cells of a property */
+class cells {
+    const fdt32_t *first_;
+    const fdt32_t *last_;
+
+public:
+    class iterator {
+        const fdt32_t *p_;
+
+    public:
+        constexpr explicit
+        iterator(const fdt32_t *p) : p_(p)
+        {
+        }
+
+        uint32_t
+        operator*() const
+        {
+            return fdt32_ld(p_);
+        }
+
+        iterator &
+        operator++()
+        {
+            p_++;
+
+            return *this;
+        }
+
+        bool
+        operator!=(const iterator &other) const
+        {
+            return p_ != other.p_;
+        }
+    };
+
+    constexpr
+    cells() : first_(nullptr), last_(nullptr)
+    {
+    }
+
+    constexpr
+    cells(const void *data, int len)
+        : first_(len > 0 ? static_cast<const fdt32_t *>(data) : nullptr),
+          last_(len > 0 ? first_ + len / sizeof(fdt32_t) : nullptr)
+    {
+    }
+
+    iterator
+    begin() const
+    {
+        return iterator(first_);
+    }
+
+    iterator
+    end() const
+    {
+        return iterator(last_);
+    }
+
+    uint32_t
+    size() const
+    {
+        return last_ - first_;
+    }
+
+    bool
+    empty() const
+    {
+        return first_ == last_;
+    }
+
+    /* No bounds check */
+    uint32_t
+    operator[](uint32_t index) const
+    {
+        return fdt32_ld(first_ + index);
+    }
+
+    /* Cells from index onwards, combined into one value. Cells which do not
+     * fit into T are dropped, from the most significant end. */
+    template <typename T = uint32_t>
+    T
+    get(uint32_t index, uint32_t count) const
+    {
+        T val = 0;
+
+        for (const fdt32_t *p = first_ + index; count > 0; p++, count--) {
+            if constexpr (sizeof(T) > 4) {
+                val = (val << 32) | fdt32_ld(p);
+            } else {
+                val = fdt32_ld(p);
+            }
+        }
+
+        return val;
+    }
+};
+
+class node;
+
+/* #address-cells and #size-cells of a bus node, for reading the reg
+ * properties of its children */
+struct bus {
+    uint8_t address_cells;
+    uint8_t size_cells;
+
+    /* The defaults of the devicetree specification */
+    constexpr
+    bus() : address_cells(2), size_cells(1)
+    {
+    }
+
+    constexpr
+    bus(uint8_t address_cells, uint8_t size_cells)
+        : address_cells(address_cells), size_cells(size_cells)
+    {
+    }
+
+    inline explicit bus(const node &n);
+};
+
+/* An entry of a reg property. Addresses and sizes of more than one cell have
+ * their upper cells dropped unless T is 64 bits. */
+template <typename T = uint32_t>
+struct reg_entry {
+    T address;
+    T size;
+};
+
+/* A reg property, as (address, size) pairs */
+template <typename T = uint32_t>
+class reg_view {
+    cells cells_;
+    bus bus_;
+    uint8_t stride_;
+
+public:
+    class iterator {
+        cells cells_;
+        bus bus_;
+        uint32_t index_;
+
+    public:
+        iterator(const cells &c, bus b, uint32_t index)
+            : cells_(c), bus_(b), index_(index)
+        {
+        }
+
+        reg_entry<T>
+        operator*() const
+        {
+            return {cells_.get<T>(index_, bus_.address_cells),
+                    cells_.get<T>(index_ + bus_.address_cells,
+                                  bus_.size_cells)};
+        }
+
+        iterator &
+        operator++()
+        {
+            index_ += bus_.address_cells + bus_.size_cells;
+
+            return *this;
+        }
+
+        bool
+        operator!=(const iterator &other) const
+        {
+            return index_ != other.index_;
+        }
+    };
+
+    reg_view(const cells &c, bus b)
+        : cells_(c), bus_(b), stride_(b.address_cells + b.size_cells)
+    {
+        /* A property that is not a whole number of entries is not a reg
+         * property */
+        if (stride_ == 0 || c.size() % stride_ != 0) {
+            cells_ = cells();
+        }
+    }
+
+    iterator
+    begin() const
+    {
+        return iterator(cells_, bus_, 0);
+    }
+
+    iterator
+    end() const
+    {
+        return iterator(cells_, bus_, cells_.size());
+    }
+
+    uint32_t
+    size() const
+    {
+        return stride_ ? cells_.size() / stride_ : 0;
+    }
+
+    bool
+    empty() const
+    {
+        return cells_.empty();
+    }
+
+    /* No bounds check */
+    reg_entry<T>
+    operator[](uint32_t index) const
+    {
+        return *iterator(cells_, bus_, index * stride_);
+    }
+};
+
+class property {
+    const void *fdt_;
+    const struct fdt_property *prop_;
+    int len_;
+
+public:
+    property(const void *fdt, int offset)
+        : fdt_(fdt), prop_(fdt_get_property_by_offset(fdt, offset, &len_))
+    {
+    }
+
+    const char *
+    name() const
+    {
+        return prop_ ? fdt_string(fdt_, fdt32_ld(&prop_->nameoff)) : nullptr;
+    }
+
+    const void *
+    data() const
+    {
+        return prop_ ? prop_->data : nullptr;
+    }
+
+    int
+    size() const
+    {
+        return prop_ ? len_ : 0;
+    }
+
+    cells
+    as_cells() const
+    {
+        return cells(data(), size());
+    }
+};
+
+/* Iterators over the subnodes and properties of a node. Each step is one call
+ * of libfdt, and the end is an offset < 0. */
+template <typename T, int (*First)(const void *, int),
+          int (*Next)(const void *, int)>
+class offsets {
+    const void *fdt_;
+    int parent_;
+
+public:
+    class iterator {
+        const void *fdt_;
+        int offset_;
+
+    public:
+        iterator(const void *fdt, int offset) : fdt_(fdt), offset_(offset)
+        {
+        }
+
+        T
+        operator*() const
+        {
+            return T(fdt_, offset_);
+        }
+
+        iterator &
+        operator++()
+        {
+            offset_ = Next(fdt_, offset_);
+
+            return *this;
+        }
+
+        bool
+        operator!=(const iterator &other) const
+        {
+            return (offset_ >= 0 || other.offset_ >= 0) &&
+                offset_ != other.offset_;
+        }
+    };
+
+    offsets(const void *fdt, int parent) : fdt_(fdt), parent_(parent)
+    {
+    }
+
+    iterator
+    begin() const
+    {
+        return iterator(fdt_, First(fdt_, parent_));
+    }
+
+    iterator
+    end() const
+    {
+        return iterator(fdt_, -FDT_ERR_NOTFOUND);
+    }
+};
+
+class node {
+    const void *fdt_;
+    int offset_;
+
+    const void *
+    getprop(const char *name, int *len) const
+    {
+        return fdt_getprop(fdt_, offset_, name, len);
+    }
+
+public:
+    node(const void *fdt, int offset) : fdt_(fdt), offset_(offset)
+    {
+    }
+
+    const void *
+    blob() const
+    {
+        return fdt_;
+    }
+
+    int
+    offset() const
+    {
+        return offset_;
+    }
+
+    bool
+    valid() const
+    {
+        return offset_ >= 0;
+    }
+
+    const char *
+    name() const
+    {
+        return fdt_get_name(fdt_, offset_, nullptr);
+    }
+
+    node
+    parent() const
+    {
+        return node(fdt_, fdt_parent_offset(fdt_, offset_));
+    }
+
+    node
+    subnode(const char *name) const
+    {
+        return node(fdt_, fdt_subnode_offset(fdt_, offset_, name));
+    }
+
+    bool
+    has(const char *name) const
+    {
+        return getprop(name, nullptr) != nullptr;
+    }
+
+    cells
+    get_cells(const char *name) const
+    {
+        int len;
+        const void *data = getprop(name, &len);
+
+        return data ? cells(data, len) : cells();
+    }
+
+    /* A property of one cell, or def if there is no such property or it is
+     * the wrong length */
+    uint32_t
+    u32(const char *name, uint32_t def) const
+    {
+        int len;
+        const void *data = getprop(name, &len);
+
+        if (data == nullptr || len != sizeof(fdt32_t)) {
+            return def;
+        }
+
+        return fdt32_ld(static_cast<const fdt32_t *>(data));
+    }
+
+    /* A string property, or nullptr if there is no such property or it is
+     * not terminated */
+    const char *
+    string(const char *name) const
+    {
+        int len;
+        const char *data = static_cast<const char *>(getprop(name, &len));
+
+        if (data == nullptr || len <= 0 || data[len - 1] != '\0') {
+            return nullptr;
+        }
+
+        return data;
+    }
+
+    bool
+    compatible(const char *compat) const
+    {
+        return fdt_node_check_compatible(fdt_, offset_, compat) == 0;
+    }
+
+    /* The reg property, read with the cells of the node's bus */
+    template <typename T = uint32_t>
+    reg_view<T>
+    reg(const bus &b) const
+    {
+        return reg_view<T>(get_cells("reg"), b);
+    }
+
+    offsets<node, fdt_first_subnode, fdt_next_subnode>
+    subnodes() const
+    {
+        return {fdt_, offset_};
+    }
+
+    offsets<property, fdt_first_property_offset, fdt_next_property_offset>
+    properties() const
+    {
+        return {fdt_, offset_};
+    }
+};
+
+/* A bus with invalid cell counts is read with the defaults */
+inline
+bus::bus(const node &n) : bus()
+{
+    int cells = fdt_address_cells(n.blob(), n.offset());
+
+    if (cells >= 0) {
+        address_cells = cells;
+    }
+
+    cells = fdt_size_cells(n.blob(), n.offset());
+
+    if (cells >= 0) {
+        size_cells = cells;
+    }
+}
+
+}
+
+#endif /* FDT_HPP */
@@ -0,0 +1,407 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+#include "alloc.h"
+
+/* Blocks are a multiple of 4 bytes long. Each begins with a header giving its
+ * size, and the address of the block before it in memory if that block is
+ * free. Free blocks also hold the links of their free list. The size includes
+ * the header, and its two low bits are flags. */
+struct block {
+    struct block *prev_phys;        /* Only valid when BLOCK_PREV_FREE */
+    uint32_t size;
+    struct block *next_free;        /* Only valid when BLOCK_FREE */
+    struct block *prev_free;
+};
+
+#define BLOCK_FREE 1
+#define BLOCK_PREV_FREE 2
+#define BLOCK_FLAGS 3
+
+#define BLOCK_HEADER offsetof(struct block, next_free)
+#define BLOCK_MIN sizeof(struct block)
+
+#define ALIGN_SHIFT 2
+
+/* Each power of 2 (first level) is split into 8 size classes (second level).
+ * Blocks under 32 bytes are all in the first level 0, in classes 4 bytes
+ * apart. */
+#define SL_SHIFT 3
+#define SL_COUNT (1 << SL_SHIFT)
+#define FL_SHIFT (SL_SHIFT + ALIGN_SHIFT)
+#define FL_MAX 22                   /* Blocks up to 4MB */
+#define FL_COUNT (FL_MAX - FL_SHIFT + 1)
+#define SMALL_BLOCK (1 << FL_SHIFT)
+
+#define BLOCK_MAX ((1UL << FL_MAX) - 1)
+
+extern uint8_t _heap_start[];
+extern uint8_t _heap_end[];
+
+struct alloc_stats heap_stats;
+
+/* The first block of the heap, or NULL if the heap is too small to use */
+static struct block *first_block;
+
+static uint32_t fl_bitmap;
+static uint8_t sl_bitmap[FL_COUNT];
+static struct block *free_list[FL_COUNT][SL_COUNT];
+
+/* Index of the highest set bit of each nibble */
+static const int8_t nibble_fls[16] = {
+    -1, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+};
+
+/* Index of the highest set bit, or -1 if none. The 68000 has no instruction
+ * for this, so it is done in a fixed number of steps. */
+static int
+highest_bit(uint32_t val)
+{
+    int bit = 0;
+
+    if (val & 0xFFFF0000) {
+        val >>= 16;
+        bit += 16;
+    }
+
+    if (val & 0xFF00) {
+        val >>= 8;
+        bit += 8;
+    }
+
+    if (val & 0xF0) {
+        val >>= 4;
+        bit += 4;
+    }
+
+    return bit + nibble_fls[val];
+}
+
+/* Index of the lowest set bit */
+static int
+lowest_bit(uint32_t val)
+{
+    return highest_bit(val & -val);
+}
+
+static inline uint32_t
+block_size(struct block *block)
+{
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline struct block *
+next_phys(struct block *block)
+{
+    return (struct block *)((uint8_t *)block + block_size(block));
+}
+
+/* Find the size class that a block of size bytes belongs in */
+static void
+mapping_insert(uint32_t size, int *fl, int *sl)
+{
+    int bit;
+
+    if (size < SMALL_BLOCK) {
+        *fl = 0;
+        *sl = size >> ALIGN_SHIFT;
+    } else {
+        bit = highest_bit(size);
+        *sl = (size >> (bit - SL_SHIFT)) ^ SL_COUNT;
+        *fl = bit - (FL_SHIFT - 1);
+    }
+}
+
+/* Find the size class to search for a block of size bytes. It is rounded up to
+ * the next class, so that any block found there is large enough. */
+static void
+mapping_search(uint32_t size, int *fl, int *sl)
+{
+    if (size >= SMALL_BLOCK) {
+        size += (1UL << (highest_bit(size) - SL_SHIFT)) - 1;
+    }
+
+    mapping_insert(size, fl, sl);
+}
+
+static void
+insert_free(struct block *block)
+{
+    int fl;
+    int sl;
+    struct block *head;
+
+    mapping_insert(block_size(block), &fl, &sl);
+
+    head = free_list[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+
+    if (head) {
+        head->prev_free = block;
+    }
+
+    free_list[fl][sl] = block;
+    fl_bitmap |= 1UL << fl;
+    sl_bitmap[fl] |= 1 << sl;
+}
+
+static void
+remove_free(struct block *block)
+{
+    int fl;
+    int sl;
+    struct block *next = block->next_free;
+    struct block *prev = block->prev_free;
+
+    mapping_insert(block_size(block), &fl, &sl);
+
+    if (next) {
+        next->prev_free = prev;
+    }
+
+    if (prev) {
+        prev->next_free = next;
+    } else {
+        free_list[fl][sl] = next;
+
+        if (next == NULL) {
+            sl_bitmap[fl] &= ~(1 << sl);
+
+            if (sl_bitmap[fl] == 0) {
+                fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+}
+
+/* Find a free block in size class fl/sl or above */
+static struct block *
+find_free(int fl, int sl)
+{
+    uint32_t map = sl_bitmap[fl] & (~0UL << sl);
+
+    if (map == 0) {
+        map = fl_bitmap & (~0UL << (fl + 1));
+
+        if (map == 0) {
+            return NULL;
+        }
+
+        fl = lowest_bit(map);
+        map = sl_bitmap[fl];
+    }
+
+    return free_list[fl][lowest_bit(map)];
+}
+
+void
+heap_init(void)
+{
+    uintptr_t start = ((uintptr_t)_heap_start + 3) & ~(uintptr_t)3;
+    uintptr_t end = (uintptr_t)_heap_end & ~(uintptr_t)3;
+    struct block *block = (struct block *)(uintptr_t)start;
+    struct block *sentinel;
+    uint32_t size;
+    uint16_t sr;
+
+    heap_stats.used = 0;
+    heap_stats.high = 0;
+
+    /* Leave the free lists empty, so that every allocation fails, if there is
+     * not room for one free block and the sentinel after it */
+    if (end < start + BLOCK_HEADER + BLOCK_MIN) {
+        return;
+    }
+
+    sr = irq_save();
+
+    /* The whole heap begins as one free block, followed by a used block with
+     * no size to stop it being merged with anything beyond the end */
+    size = end - start - BLOCK_HEADER;
+
+    if (size > BLOCK_MAX) {
+        size = BLOCK_MAX & ~3UL;
+    }
+
+    block->size = size | BLOCK_FREE;
+
+    sentinel = next_phys(block);
+    sentinel->prev_phys = block;
+    sentinel->size = BLOCK_PREV_FREE;
+
+    insert_free(block);
+    first_block = block;
+
+    irq_restore(sr);
+}
+
+void *
+heap_alloc(uint32_t size)
+{
+    struct block *block;
+    struct block *rest;
+    uint32_t have;
+    int fl;
+    int sl;
+    uint16_t sr;
+
+    if (size == 0 || size > BLOCK_MAX - BLOCK_HEADER) {
+        return NULL;
+    }
+
+    size = (size + BLOCK_HEADER + 3) & ~3UL;
+
+    if (size < BLOCK_MIN) {
+        size = BLOCK_MIN;
+    }
+
+    mapping_search(size, &fl, &sl);
+
+    sr = irq_save();
+
+    block = (fl < FL_COUNT) ? find_free(fl, sl) : NULL;
+
+    if (block == NULL) {
+        /* The block at the head of the size's own class may still be large
+         * enough, which matters when most of the heap is in one block */
+        mapping_insert(size, &fl, &sl);
+
+        if (fl < FL_COUNT) {
+            block = free_list[fl][sl];
+
+            if (block && block_size(block) < size) {
+                block = NULL;
+            }
+        }
+    }
+
+    if (block == NULL) {
+        heap_stats.fails++;
+        irq_restore(sr);
+
+        return NULL;
+    }
+
+    remove_free(block);
+    have = block_size(block);
+
+    if (have - size >= BLOCK_MIN) {
+        /* Split off the rest of the block and return it to the free lists */
+        rest = (struct block *)((uint8_t *)block + size);
+        rest->size = (have - size) | BLOCK_FREE;
+        next_phys(rest)->prev_phys = rest;
+        insert_free(rest);
+
+        block->size = size | (block->size & BLOCK_PREV_FREE);
+    } else {
+        block->size &= ~BLOCK_FREE;
+        next_phys(block)->size &= ~BLOCK_PREV_FREE;
+    }
+
+    heap_stats.used += block_size(block);
+    heap_stats.allocs++;
+
+    if (heap_stats.used > heap_stats.high) {
+        heap_stats.high = heap_stats.used;
+    }
+
+    irq_restore(sr);
+
+    return (uint8_t *)block + BLOCK_HEADER;
+}
+
+void
+heap_free(void *ptr)
+{
+    struct block *block;
+    struct block *other;
+    uint16_t sr;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    block = (struct block *)((uint8_t *)ptr - BLOCK_HEADER);
+
+    sr = irq_save();
+
+    heap_stats.used -= block_size(block);
+    heap_stats.frees++;
+
+    /* Merge with the free blocks either side, if there are any */
+    if (block->size & BLOCK_PREV_FREE) {
+        other = block->prev_phys;
+        remove_free(other);
+        other->size += block_size(block);
+        block = other;
+    }
+
+    other = next_phys(block);
+
+    if (other->size & BLOCK_FREE) {
+        remove_free(other);
+        block->size += block_size(other);
+    }
+
+    block->size |= BLOCK_FREE;
+
+    other = next_phys(block);
+    other->prev_phys = block;
+    other->size |= BLOCK_PREV_FREE;
+
+    insert_free(block);
+
+    irq_restore(sr);
+}
+
+void
+heap_usage(struct heap_usage *usage)
+{
+    struct block *block = first_block;
+    uint32_t size;
+    uint16_t sr;
+
+    usage->size = _heap_end - _heap_start;
+    usage->free = 0;
+    usage->largest = 0;
+    usage->free_blocks = 0;
+    usage->fragmentation = 0;
+
+    if (block == NULL) {
+        return;
+    }
+
+    /* Walk every block, which unlike the rest of the heap takes longer the
+     * more blocks there are */
+    sr = irq_save();
+
+    while ((size = block_size(block)) != 0) {
+        if (block->size & BLOCK_FREE) {
+            size -= BLOCK_HEADER;
+            usage->free += size;
+            usage->free_blocks++;
+
+            if (size > usage->largest) {
+                usage->largest = size;
+            }
+        }
+
+        block = next_phys(block);
+    }
+
+    irq_restore(sr);
+
+    if (usage->free) {
+        usage->fragmentation = 100 - (usage->largest * 100) / usage->free;
+    }
+}
+
+void
+alloc_tick(struct alloc_stats *stats)
+{
+    uint32_t allocs = stats->allocs;
+
+    stats->rate = allocs - stats->last;
+    stats->last = allocs;
+}
@@ -0,0 +1,185 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include "TL16C2552.h"
+#include "cpu.h"
+#include "log.h"
+
+#define LOG_BUF_MASK (LOG_BUF_SIZE - 1)
+
+#if (LOG_BUF_SIZE & LOG_BUF_MASK) != 0
+#error "LOG_BUF_SIZE must be a power of 2"
+#endif
+
+static uint8_t log_buf[LOG_BUF_SIZE];
+static volatile uint16_t log_head;  /* Where the next record is written */
+static volatile uint16_t log_tail;  /* Next byte to be sent */
+static uint8_t log_flags;
+static uint32_t log_count;
+
+volatile uint32_t log_dropped;      /* Records lost since the last report */
+
+uint32_t __attribute__((weak))
+log_timestamp(void)
+{
+    return log_count;
+}
+
+void
+log_init(uint8_t flags)
+{
+    log_flags = flags;
+    log_head = 0;
+    log_tail = 0;
+    log_dropped = 0;
+}
+
+/* Append a record to the buffer. Called with interrupts masked, and with
+ * enough space known to be free. Returns the new head. */
+static uint16_t
+log_put(uint16_t head, uint16_t id, uint8_t nargs, const uint32_t *args)
+{
+    uint32_t val = log_timestamp();
+    uint8_t sum;
+    uint8_t byte;
+    uint8_t ctr;
+
+    log_buf[head] = LOG_SYNC;
+    head = (head + 1) & LOG_BUF_MASK;
+
+    log_buf[head] = nargs;
+    head = (head + 1) & LOG_BUF_MASK;
+    sum = nargs;
+
+    byte = id >> 8;
+    log_buf[head] = byte;
+    head = (head + 1) & LOG_BUF_MASK;
+    sum += byte;
+
+    byte = id;
+    log_buf[head] = byte;
+    head = (head + 1) & LOG_BUF_MASK;
+    sum += byte;
+
+    /* The timestamp, followed by each argument, most significant byte first */
+    for (;;) {
+        for (ctr = 4; ctr; ctr--) {
+            byte = val >> 24;
+            log_buf[head] = byte;
+            head = (head + 1) & LOG_BUF_MASK;
+            sum += byte;
+            val <<= 8;
+        }
+
+        if (nargs == 0) {
+            break;
+        }
+
+        nargs--;
+        val = *args++;
+    }
+
+    /* Bytes after the sync add up to zero */
+    log_buf[head] = -sum;
+    head = (head + 1) & LOG_BUF_MASK;
+
+    log_count++;
+
+    return head;
+}
+
+void
+log_write(uint16_t id, uint8_t nargs, ...)
+{
+    uint16_t len;
+    uint16_t sr;
+    uint16_t head;
+    uint16_t space;
+    uint32_t args[LOG_MAX_ARGS];
+    uint32_t dropped;
+    uint8_t ctr;
+    va_list ap;
+
+    if (nargs > LOG_MAX_ARGS) {
+        nargs = LOG_MAX_ARGS;
+    }
+
+    len = LOG_HEADER_LEN + (nargs * 4) + 1;
+
+    /* Arguments are collected before interrupts are masked */
+    va_start(ap, nargs);
+
+    for (ctr = 0; ctr < nargs; ctr++) {
+        args[ctr] = va_arg(ap, uint32_t);
+    }
+
+    va_end(ap);
+
+    sr = irq_save();
+
+    head = log_head;
+    space = (log_tail - head - 1) & LOG_BUF_MASK;
+
+    /* Report any records that were lost before this one, if both fit */
+    if (log_dropped) {
+        if (space < len + LOG_HEADER_LEN + 4 + 1) {
+            log_dropped++;
+            irq_restore(sr);
+
+            return;
+        }
+
+        dropped = log_dropped;
+        head = log_put(head, LOG_ID_DROPPED, 1, &dropped);
+        log_dropped = 0;
+    } else if (space < len) {
+        log_dropped = 1;
+        irq_restore(sr);
+
+        return;
+    }
+
+    log_head = log_put(head, id, nargs, args);
+
+    if (log_flags & LOG_IRQ) {
+        UAIERbits.TXEMPTY = 1;
+    }
+
+    irq_restore(sr);
+}
+
+void
+log_poll(void)
+{
+    uint16_t tail = log_tail;
+    uint8_t ctr;
+
+    if (UALSRbits.THRE == 0) {
+        return;
+    }
+
+    /* The transmit FIFO is empty, so up to 16 bytes can be written at once */
+    for (ctr = 16; ctr && tail != log_head; ctr--) {
+        UATHR = log_buf[tail];
+        tail = (tail + 1) & LOG_BUF_MASK;
+    }
+
+    log_tail = tail;
+
+    if ((log_flags & LOG_IRQ) && tail == log_head) {
+        UAIERbits.TXEMPTY = 0;
+    }
+}
+
+void
+log_flush(void)
+{
+    /* The interrupt handler cannot run if the mask is at or above the level of
+     * the UART, such as when flushing from a handler or with irq_save() */
+    uint8_t polled = !(log_flags & LOG_IRQ) || irq_mask() >= DT_SERIAL0_IRQ;
+
+    while (log_tail != log_head) {
+        if (polled) {
+            log_poll();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Binary logging
+ *
+ * LOG() works like printf(), except that no formatting is done on the target.
+ * Instead a short record holding the ID of the format string, a timestamp and
+ * the raw argument values is placed in a ring buffer, from which it is sent
+ * out of UART channel A by log_poll(). logdecode.py (in COMET68k_bootloader)
+ * turns the records back into text on the host, using the format strings from
+ * the ELF file.
+ *
+ * The format strings are placed in the .logstr section, which is not loaded
+ * into ROM or RAM (see platform.ld). The ID of a string is its offset within
+ * that section, and the linker script checks that every ID is below
+ * LOG_ID_DROPPED.
+ *
+ * Up to LOG_MAX_ARGS arguments may be given. Each is sent as 32 bits, so only
+ * integer, char and pointer arguments can be used. %s is only useful for
+ * strings in ROM, as the host reads them from the ELF file. */
+
+#define LOG_BUF_SIZE 1024           /* Must be a power of 2 */
+#define LOG_MAX_ARGS 6
+
+#define LOG_SYNC 0x1E               /* First byte of every record */
+#define LOG_HEADER_LEN 8            /* Sync, arg count, ID and timestamp */
+#define LOG_ID_DROPPED 0xFFFF       /* Records lost while the buffer was full.
+                                     * The argument is the number lost. */
+
+/* Flags for log_init() */
+#define LOG_POLLED 0                /* log_poll() is called by the program */
+#define LOG_IRQ 1                   /* log_poll() is called from the UART
+                                     * interrupt handler, and the transmit
+                                     * empty interrupt is enabled as needed */
+
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+
+#define LOG(fmt, ...)                                                         \
+    do {                                                                      \
+        static const char __log_fmt[]                                         \
+            __attribute__((section(".logstr"), aligned(1))) = fmt;            \
+        log_write((uint16_t)(uintptr_t)__log_fmt, LOG_NARGS(__VA_ARGS__),     \
+                  ##__VA_ARGS__);                                             \
+    } while (0)
+
+extern volatile uint32_t log_dropped;
+
+void log_init(uint8_t flags);
+void log_write(uint16_t id, uint8_t nargs, ...);
+void log_poll(void);
+
+/* Wait until every record has been sent. With LOG_IRQ, the interrupt handler
+ * sends them, unless the UART interrupt is masked, when they are polled out
+ * instead. */
+void log_flush(void);
+
+/* Returns the timestamp placed in each record. The default counts records,
+ * programs with a timer can provide their own. */
+uint32_t log_timestamp(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_H */
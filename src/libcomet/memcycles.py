@@ -0,0 +1,243 @@
+# Cycle counts for the memory block routines in mem.S
+#
+# There is no cycle counter on the 68000, so rather than being measured the
+# counts are worked out from the instruction timings in the MC68000 User's
+# Manual (section 8), following each path through the code for a given
+# length and alignment. They assume no wait states, and ignore DRAM refresh.
+#
+# The same is done for the word at a time loops that crt0.S used before, and
+# for a simple byte loop as compiled C would do, for comparison.
+#
+#   python3 memcycles.py [--clock MHz] [sizes...]
+
+import argparse
+
+# Timings of the instructions used, in clock cycles
+T = {
+    'jsr.l': 20, 'bsr': 18, 'rts': 16,
+    'move.l (sp)': 16, 'movea.l (sp)': 16,
+    'tst.l': 4, 'bcc.w nt': 12, 'bcc.s nt': 8, 'bcc t': 10, 'bra': 10,
+    'dbf t': 10, 'dbf x': 14,
+    'move.w An,Dn': 4, 'sub.w An,Dn': 4, 'lsr.b #1': 8, 'lsr.w #1': 8,
+    'lsr.w #4': 14, 'lsr.l #2': 12, 'lsr.l #5': 18,
+    'move.b (+),(+)': 12, 'move.w (+),(+)': 12, 'move.l (+),(+)': 20,
+    'move.b (-),(-)': 14, 'move.w (-),(-)': 14, 'move.l (-),(-)': 22,
+    'subq.l': 8, 'cmp.l #': 14, 'sub.l #': 16, 'and.w #': 8, 'and.l #': 16,
+    'btst #,Dn': 10, 'move.l': 4, 'move.w': 4, 'movea.l': 4, 'movea.w': 4,
+    'adda.l': 8, 'lea d(An)': 8, 'lsl.w #8': 22, 'add.w': 4, 'swap': 4,
+    'exg': 6, 'moveq': 4,
+    'move.b Dn,(+)': 8, 'move.b Dn,(-)': 8, 'move.w Dn,(-)': 8,
+    'move.l Dn,(-)': 12,
+    'clr.w (+)': 12, 'cmpa.l': 6,
+}
+
+MOVEM_MIN = 256
+MOVEM_REGS = 8
+
+
+def movem_load(n):
+    return 12 + 8 * n
+
+
+def movem_store(n):
+    return 8 + 8 * n
+
+
+def dbf_loop(iterations: int, body: int) -> int:
+    """ Cycles for a dbf loop with a 32 bit count, as used in mem.S """
+    cycles = iterations * (body + T['dbf t'])
+    outer = (iterations + 0xFFFF) // 0x10000
+
+    # Each pass of the outer loop ends with an expired dbf instead of a taken
+    # one, then the sub.l and bpl
+    cycles += outer * (T['dbf x'] - T['dbf t'] + T['sub.l #'] + T['bcc t'])
+    cycles += T['bcc.s nt'] - T['bcc t']
+
+    return cycles
+
+
+def tail_copy(n: int) -> int:
+    """ Cycles to copy fewer than MOVEM_MIN bytes with both pointers even """
+    c = T['move.w'] + T['lsr.w #4'] + T['bra']
+    c += (n >> 4) * (4 * T['move.l (+),(+)'] + T['dbf t']) + T['dbf x']
+
+    for bit, cost in ((8, 2 * T['move.l (+),(+)']), (4, T['move.l (+),(+)']),
+                      (2, T['move.w (+),(+)']), (1, T['move.b (+),(+)'])):
+        c += T['btst #,Dn']
+        c += cost + T['bcc.s nt'] if n & bit else T['bcc t']
+
+    return c
+
+
+def mem_copy(src: int, dst: int, n: int) -> int:
+    """ Cycles for __mem_copy, excluding the call and return """
+    c = T['tst.l']
+
+    if n == 0:
+        return c + T['bcc t']
+
+    c += T['bcc.w nt'] + T['move.w An,Dn'] + T['sub.w An,Dn'] + T['lsr.b #1']
+
+    if (src - dst) & 1:
+        c += T['bcc t'] + T['move.l'] + T['lsr.l #2']
+        longs = n >> 2
+
+        if longs:
+            c += T['bcc.s nt'] + T['subq.l']
+            c += dbf_loop(longs, 4 * T['move.b (+),(+)'])
+        else:
+            c += T['bcc t']
+
+        c += T['and.w #'] + T['bra']
+        c += (n & 3) * (T['move.b (+),(+)'] + T['dbf t']) + T['dbf x']
+
+        return c
+
+    c += T['bcc.w nt'] + T['move.w An,Dn'] + T['lsr.b #1']
+
+    if src & 1:
+        c += T['bcc.s nt'] + T['move.b (+),(+)'] + T['subq.l'] + T['bcc.w nt']
+        n -= 1
+    else:
+        c += T['bcc t']
+
+    c += T['cmp.l #']
+
+    if n >= MOVEM_MIN:
+        c += T['bcc.s nt']
+        c += movem_store(MOVEM_REGS) + T['move.l'] + T['lsr.l #5']
+        c += T['subq.l']
+        c += dbf_loop(n >> 5, movem_load(MOVEM_REGS) +
+                      movem_store(MOVEM_REGS) + T['lea d(An)'])
+        c += movem_load(MOVEM_REGS) + T['and.w #']
+        n &= 31
+    else:
+        c += T['bcc t']
+
+    return c + tail_copy(n)
+
+
+def mem_fill(dst: int, n: int) -> int:
+    """ Cycles for __mem_fill, excluding the call and return """
+    c = T['tst.l']
+
+    if n == 0:
+        return c + T['bcc t']
+
+    c += T['bcc.w nt'] + T['and.w #'] + T['movea.w'] + T['lsl.w #8']
+    c += T['add.w'] + T['movea.w'] + T['swap'] + T['move.w']
+    c += 2 * T['exg'] + T['move.w An,Dn'] + T['btst #,Dn']
+
+    if dst & 1:
+        c += T['bcc.s nt'] + T['move.b Dn,(+)'] + T['subq.l'] + T['bcc.w nt']
+        n -= 1
+    else:
+        c += T['bcc t']
+
+    c += T['cmp.l #']
+
+    if n >= MOVEM_MIN:
+        c += T['bcc.s nt'] + movem_store(MOVEM_REGS)
+        c += MOVEM_REGS * T['move.l']
+        c += T['move.l'] + T['and.l #'] + T['movea.l'] + T['adda.l']
+        c += T['lsr.l #5'] + T['subq.l']
+        c += dbf_loop(n >> 5, movem_store(MOVEM_REGS))
+        c += T['move.l'] + T['and.l #'] + T['adda.l'] + T['move.l']
+        c += movem_load(MOVEM_REGS) + T['and.l #']
+        n &= 31
+    else:
+        c += T['bcc t']
+
+    c += T['movea.l'] + T['adda.l']
+
+    for bit, cost in ((1, T['move.b Dn,(-)']), (2, T['move.w Dn,(-)']),
+                      (4, T['move.l Dn,(-)'])):
+        c += T['lsr.w #1']
+        c += cost + T['bcc.s nt'] if n & bit else T['bcc t']
+
+    c += T['lsr.w #1']
+
+    if n & 8:
+        c += T['bcc.s nt'] + 2 * T['move.l Dn,(-)'] + T['bra']
+    else:
+        c += T['bcc t']
+
+    c += (n >> 4) * (4 * T['move.l Dn,(-)'] + T['dbf t']) + T['dbf x']
+
+    return c
+
+
+def call(cycles: int, args: int) -> int:
+    """ Add the cost of calling through the C entry point """
+    return (T['jsr.l'] + args * T['move.l (sp)'] + T['bsr'] + cycles +
+            2 * T['rts'] + T['move.l (sp)'] + T['movea.l'])
+
+
+def old_crt0(n: int) -> int:
+    """ The word at a time loops that crt0.S used to clear .bss and copy
+    .data: a move or clear, a compare and two branches per word """
+    words = (n + 1) // 2
+
+    return (T['movea.l'] * 2 + words * (T['clr.w (+)'] + T['cmpa.l'] +
+            T['bcc.s nt'] + T['bra']) + T['cmpa.l'] + T['bcc t'])
+
+
+def old_vectors() -> int:
+    return 512 * (T['move.w (+),(+)'] + T['dbf t']) + T['dbf x'] - T['dbf t']
+
+
+def byte_loop(n: int) -> int:
+    """ while (n--) *d++ = *s++; as compiled for the 68000 """
+    return n * (T['move.b (+),(+)'] + T['subq.l'] + T['bcc t'])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Cycle counts for the memory block routines in mem.S'
+    )
+    parser.add_argument(
+        'sizes',
+        type=int, nargs='*', default=[16, 64, 256, 1024, 4096, 65536],
+        help='Block sizes in bytes'
+    )
+    parser.add_argument(
+        '--clock',
+        dest='clock', type=float, default=10,
+        help='CPU clock in MHz, for times (default 10)'
+    )
+    args = parser.parse_args()
+
+    def us(cycles):
+        return cycles / args.clock
+
+    print('Start up (crt0.S), cycles')
+    print(f"{'':16} {'Bytes':>7} {'Before':>9} {'After':>9} {'Speedup':>8}")
+
+    for n in args.sizes:
+        old = old_crt0(n)
+        fill = T['jsr.l'] + mem_fill(0, n) + T['rts']
+        copy = T['jsr.l'] + mem_copy(0, 0, n) + T['rts']
+
+        print(f"{'.bss clear':16} {n:7} {old:9} {fill:9} {old / fill:7.1f}x")
+        print(f"{'.data copy':16} {n:7} {old:9} {copy:9} {old / copy:7.1f}x")
+
+    old = old_vectors()
+    new = T['jsr.l'] + mem_copy(0, 0, 1024) + T['rts']
+
+    print(f"{'Vector copy':16} {1024:7} {old:9} {new:9} {old / new:7.1f}x")
+    print()
+    print('Bulk copies via the C entry points, cycles per byte')
+    print(f"{'Bytes':>7} {'Byte loop':>10} {'memcpy':>8} {'unaligned':>10} "
+          f"{'memset':>8} {'memcpy us':>10}")
+
+    for n in args.sizes:
+        copy = call(mem_copy(0, 0, n), 3)
+        odd = call(mem_copy(1, 0, n), 3)
+        fill = call(mem_fill(0, n), 3)
+
+        print(f'{n:7} {byte_loop(n) / n:10.2f} {copy / n:8.2f} '
+              f'{odd / n:10.2f} {fill / n:8.2f} {us(copy):10.1f}')
+
+
+if __name__ == '__main__':
+    main()
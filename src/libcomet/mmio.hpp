@@ -0,0 +1,145 @@
+#ifndef MMIO_HPP
+#define MMIO_HPP
+
+#include <stdint.h>
+
+/* Memory mapped registers for C++
+ *
+ * A register is a type rather than an object, with its address as a template
+ * parameter, so every access compiles to a single move to or from an absolute
+ * address, the same as the macros in TL16C2552.h. Fields are described by
+ * their position and width within a register, and are checked at compile time
+ * to fit within it.
+ *
+ *   using lsr = mmio::reg<0xC2000D>;
+ *   using lsr_thre = mmio::field<lsr, 5, 1>;
+ *
+ *   while (!lsr_thre::read());
+ *
+ * Writing a field on its own reads the register, modifies it and writes it
+ * back, which on the X-bus is two slow accesses for each field. Calling a field
+ * instead gives its value, and values for fields of the same register can be
+ * combined with | and written all at once, so that setting up a register
+ * takes a single store:
+ *
+ *   lcr::write(lcr_dlab(1) | lcr_wlen(3));
+ *
+ * where lcr_dlab and lcr_wlen are field objects rather than types. Headers of
+ * these for each register are generated by structbits.py (in
+ * COMET68k_bootloader), e.g. TL16C2552.hpp. Values for a different register
+ * will not compile.
+ */
+
+namespace mmio {
+
+/* Values for one or more fields of the register at Addr, in position, and the
+ * bits that they cover */
+template <uintptr_t Addr, typename T>
+struct bits {
+    T value;
+    T mask;
+
+    constexpr bits
+    operator|(bits other) const
+    {
+        return {static_cast<T>(value | other.value),
+                static_cast<T>(mask | other.mask)};
+    }
+};
+
+template <uintptr_t Addr, typename T = uint8_t>
+struct reg {
+    using type = T;
+
+    static constexpr uintptr_t address = Addr;
+
+    static volatile T &
+    ref()
+    {
+        return *reinterpret_cast<volatile T *>(Addr);
+    }
+
+    static T
+    read()
+    {
+        return ref();
+    }
+
+    static void
+    write(T val)
+    {
+        ref() = val;
+    }
+
+    /* Write the whole register at once. Fields not given are written as
+     * zero. */
+    static void
+    write(bits<Addr, T> val)
+    {
+        ref() = val.value;
+    }
+
+    /* Replace the fields given with one read and one write, leaving the rest
+     * of the register as it was */
+    static void
+    modify(bits<Addr, T> val)
+    {
+        ref() = (ref() & ~val.mask) | val.value;
+    }
+
+    /* Read, modify and write back */
+    static void
+    set(T bits)
+    {
+        ref() = ref() | bits;
+    }
+
+    static void
+    clear(T bits)
+    {
+        ref() = ref() & ~bits;
+    }
+};
+
+template <typename Reg, unsigned Shift, unsigned Width>
+struct field {
+    using type = typename Reg::type;
+
+    static_assert(Width > 0 && Shift + Width <= sizeof(type) * 8,
+                  "Field does not fit within its register");
+
+    static constexpr type mask =
+        static_cast<type>(((1UL << Width) - 1) << Shift);
+
+    static type
+    read()
+    {
+        return (Reg::read() & mask) >> Shift;
+    }
+
+    /* Replace the field, leaving the rest of the register as it was */
+    static void
+    write(type val)
+    {
+        Reg::write((Reg::read() & ~mask) | ((val << Shift) & mask));
+    }
+
+    /* The value of the field, in position, for building up a whole register
+     * to be written at once */
+    static constexpr type
+    value(type val)
+    {
+        return (val << Shift) & mask;
+    }
+
+    /* The same, to be combined with other fields of the register */
+    constexpr bits<Reg::address, type>
+    operator()(type val) const
+    {
+        return {value(val), mask};
+    }
+};
+
+}
+
+#endif /* MMIO_HPP */
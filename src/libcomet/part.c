@@ -0,0 +1,86 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "part.h"
+
+const struct part_table *
+part_open(uintptr_t base, uint32_t size)
+{
+    const struct part_table *table =
+        (const struct part_table *)(base + size - PART_TABLE_SIZE);
+    const struct part_entry *part;
+    uint16_t ctr;
+
+    if (table->magic != PART_MAGIC || table->version != PART_VERSION ||
+        table->size != size || table->count > PART_MAX) {
+        return NULL;
+    }
+
+    if (crc32(0, table->entries,
+              table->count * sizeof(struct part_entry)) != table->crc) {
+        return NULL;
+    }
+
+    /* Every partition must lie below the table */
+    for (ctr = 0, part = table->entries; ctr < table->count; ctr++, part++) {
+        if (part->length > part->size ||
+            part->size > size - PART_TABLE_SIZE ||
+            part->offset > size - PART_TABLE_SIZE - part->size) {
+            return NULL;
+        }
+    }
+
+    return table;
+}
+
+const struct part_entry *
+part_find(const struct part_table *table, const char *name)
+{
+    const struct part_entry *part = table->entries;
+    uint16_t ctr;
+    uint8_t len;
+
+    for (ctr = table->count; ctr; ctr--, part++) {
+        for (len = 0; len < PART_NAME_LEN; len++) {
+            if (part->name[len] != name[len] || name[len] == '\0') {
+                break;
+            }
+        }
+
+        /* A match if every character matched, up to the end of name */
+        if ((len == PART_NAME_LEN && name[len] == '\0') ||
+            (len < PART_NAME_LEN && part->name[len] == name[len])) {
+            return part;
+        }
+    }
+
+    return NULL;
+}
+
+const struct part_entry *
+part_find_type(const struct part_table *table, uint8_t type,
+               const struct part_entry *after)
+{
+    const struct part_entry *part = after ? after + 1 : table->entries;
+    const struct part_entry *end = table->entries + table->count;
+
+    for (; part < end; part++) {
+        if (part->type == type) {
+            return part;
+        }
+    }
+
+    return NULL;
+}
+
+const void *
+part_data(const struct part_table *table, const struct part_entry *part)
+{
+    return (const uint8_t *)table + PART_TABLE_SIZE - table->size +
+        part->offset;
+}
+
+int
+part_verify(const struct part_table *table, const struct part_entry *part)
+{
+    return crc32(0, part_data(table, part), part->length) == part->crc ? 0 : -1;
+}
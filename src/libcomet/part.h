@@ -0,0 +1,92 @@
+#ifndef PART_H
+#define PART_H
+
+#include <stdint.h>
+#include "crc32.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ROM partitions
+ *
+ * make_image.py divides a ROM image into partitions (the bootloader,
+ * applications, the devicetree blob, read only filesystems and so on), and
+ * lists them in a table in the last PART_TABLE_SIZE bytes of the image, with a
+ * CRC32 of each. part_open() finds and checks the table, and the partitions
+ * can then be looked up by name or type, and each checked on its own with
+ * part_verify(), so that start up only checks what it uses.
+ *
+ * Partition contents are used where they are in ROM: part_data() returns a
+ * pointer to them. See parttable.py (in COMET68k_bootloader) for the layout,
+ * which the structures below follow. */
+
+#define PART_TABLE_SIZE 0x200
+#define PART_MAGIC 0x43505431       /* "CPT1" */
+#define PART_VERSION 1
+#define PART_MAX 12
+#define PART_NAME_LEN 8
+
+#define PART_ROM0 0xF00000          /* Base addresses of the two ROMs */
+#define PART_ROM1 0xF80000
+#define PART_ROM_SIZE 0x80000
+
+/* Partition types */
+#define PART_TYPE_BOOT 1
+#define PART_TYPE_APP 2
+#define PART_TYPE_DTB 3
+#define PART_TYPE_ROMFS 4
+#define PART_TYPE_DATA 5
+
+/* Partition flags */
+#define PART_FLAG_EXEC 0x01         /* load is the address it runs from */
+#define PART_FLAG_COMPRESSED 0x02
+
+struct part_entry {
+    char name[PART_NAME_LEN];       /* Padded with zeros, not terminated if
+                                     * all 8 are used */
+    uint8_t type;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t offset;                /* From the start of the ROM */
+    uint32_t size;                  /* Space allotted, in whole sectors */
+    uint32_t length;                /* Space used */
+    uint32_t load;
+    uint32_t crc;                   /* CRC32 of the first length bytes */
+    uint32_t src_crc;               /* Used by make_image.py */
+    uint32_t reserved2;
+};
+
+struct part_table {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;                  /* Size of the ROM image */
+    uint32_t crc;                   /* CRC32 of the entries */
+    struct part_entry entries[];
+};
+
+/* Find and check the table of the ROM image at base, e.g. PART_ROM1. Returns
+ * NULL if there is no valid table. */
+const struct part_table *part_open(uintptr_t base, uint32_t size);
+
+/* Find a partition by name, or the first (after is NULL) or next partition of
+ * a type. Return NULL if there are no more. */
+const struct part_entry *part_find(const struct part_table *table,
+                                   const char *name);
+const struct part_entry *part_find_type(const struct part_table *table,
+                                        uint8_t type,
+                                        const struct part_entry *after);
+
+/* Address of a partition's contents in ROM */
+const void *part_data(const struct part_table *table,
+                      const struct part_entry *part);
+
+/* Returns 0 if the CRC32 of a partition's contents is correct */
+int part_verify(const struct part_table *table, const struct part_entry *part);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PART_H */
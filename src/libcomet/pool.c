@@ -0,0 +1,109 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+#include "alloc.h"
+
+void
+pool_init(struct pool *pool, void *mem, uint16_t size, uint16_t count)
+{
+    uint8_t *block = mem;
+    void **link = &pool->free;
+
+    /* Blocks must be able to hold the free list link, and stay aligned */
+    size = (size + 3) & ~3;
+
+    if (size < sizeof(void *)) {
+        size = sizeof(void *);
+    }
+
+    pool->size = size;
+    pool->count = count;
+
+    for (; count; count--) {
+        *link = block;
+        link = (void **)block;
+        block += size;
+    }
+
+    *link = NULL;
+
+    pool->stats.used = 0;
+    pool->stats.high = 0;
+    pool->stats.allocs = 0;
+    pool->stats.frees = 0;
+    pool->stats.fails = 0;
+    pool->stats.rate = 0;
+    pool->stats.last = 0;
+}
+
+int
+pool_create(struct pool *pool, uint16_t size, uint16_t count)
+{
+    void *mem;
+
+    size = (size + 3) & ~3;
+
+    if (size < sizeof(void *)) {
+        size = sizeof(void *);
+    }
+
+    mem = heap_alloc((uint32_t)size * count);
+
+    if (mem == NULL) {
+        return -1;
+    }
+
+    pool_init(pool, mem, size, count);
+
+    return 0;
+}
+
+void *
+pool_alloc(struct pool *pool)
+{
+    void **block;
+    uint16_t sr;
+
+    sr = irq_save();
+
+    block = pool->free;
+
+    if (block == NULL) {
+        pool->stats.fails++;
+        irq_restore(sr);
+
+        return NULL;
+    }
+
+    pool->free = *block;
+
+    pool->stats.allocs++;
+
+    if (++pool->stats.used > pool->stats.high) {
+        pool->stats.high = pool->stats.used;
+    }
+
+    irq_restore(sr);
+
+    return block;
+}
+
+void
+pool_free(struct pool *pool, void *block)
+{
+    uint16_t sr;
+
+    if (block == NULL) {
+        return;
+    }
+
+    sr = irq_save();
+
+    *(void **)block = pool->free;
+    pool->free = block;
+
+    pool->stats.used--;
+    pool->stats.frees++;
+
+    irq_restore(sr);
+}
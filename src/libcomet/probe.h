@@ -0,0 +1,31 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bus error recovery
+ *
+ * Reading an address where nothing answers ends in a bus error once the bus
+ * watchdog in the CPLD gives up on DTACK/. These read a byte or a word with a
+ * bus error handler of their own in place, so that an empty address can be
+ * told apart from one that answers, e.g. to find expansion cards. Interrupts
+ * are masked while the handler is in place.
+ *
+ * Each returns 0 and stores the value read in *val, or returns -1 if the read
+ * ended in a bus error. The exception frame is thrown away rather than
+ * returned from, so this works whatever its format (68000 or 68010). */
+
+int probe_read8(const volatile void *addr, uint8_t *val);
+
+/* addr must be even */
+int probe_read16(const volatile void *addr, uint16_t *val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROBE_H */
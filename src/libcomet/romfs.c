@@ -0,0 +1,148 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "romfs.h"
+
+/* Compare the name at a to b, as unsigned bytes, as romfs.py sorts them */
+static int
+compare(const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+const struct romfs *
+romfs_open(const void *base, uint32_t size)
+{
+    const struct romfs *fs = base;
+    const struct romfs_entry *file;
+    const char *names;
+    const char *end;
+    uint32_t dir_len;
+    uint16_t ctr;
+
+    if (size < sizeof(struct romfs) || fs->magic != ROMFS_MAGIC ||
+        fs->version != ROMFS_VERSION || fs->size > size) {
+        return NULL;
+    }
+
+    dir_len = fs->count * sizeof(struct romfs_entry);
+
+    if (fs->size < sizeof(struct romfs) + dir_len) {
+        return NULL;
+    }
+
+    /* The names follow the entries, and the last ends the directory */
+    names = (const char *)fs + sizeof(struct romfs) + dir_len;
+    end = (const char *)fs + fs->size;
+
+    for (ctr = fs->count; ctr; ctr--) {
+        while (names < end && *names) {
+            names++;
+        }
+
+        if (names++ == end) {
+            return NULL;
+        }
+    }
+
+    dir_len = names - (const char *)fs->entries;
+
+    if (crc32(0, fs->entries, dir_len) != fs->crc) {
+        return NULL;
+    }
+
+    for (ctr = 0, file = fs->entries; ctr < fs->count; ctr++, file++) {
+        if (file->name < sizeof(struct romfs) +
+                fs->count * sizeof(struct romfs_entry) ||
+            file->name >= sizeof(struct romfs) + dir_len ||
+            file->offset > fs->size ||
+            file->length > fs->size - file->offset) {
+            return NULL;
+        }
+    }
+
+    return fs;
+}
+
+const struct romfs *
+romfs_open_part(uintptr_t rom, const char *name)
+{
+    const struct part_table *table = part_open(rom, PART_ROM_SIZE);
+    const struct part_entry *part;
+
+    if (table == NULL) {
+        return NULL;
+    }
+
+    part = part_find(table, name);
+
+    if (part == NULL || part->type != PART_TYPE_ROMFS) {
+        return NULL;
+    }
+
+    return romfs_open(part_data(table, part), part->length);
+}
+
+const struct romfs_entry *
+romfs_find(const struct romfs *fs, const char *name)
+{
+    const struct romfs_entry *file;
+    uint16_t low = 0;
+    uint16_t high = fs->count;
+    uint16_t mid;
+    int diff;
+
+    while (low < high) {
+        mid = (low + high) >> 1;
+        file = &fs->entries[mid];
+        diff = compare(romfs_name(fs, file), name);
+
+        if (diff == 0) {
+            return file;
+        } else if (diff < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+const void *
+romfs_data(const struct romfs *fs, const struct romfs_entry *file)
+{
+    return (const uint8_t *)fs + file->offset;
+}
+
+const char *
+romfs_name(const struct romfs *fs, const struct romfs_entry *file)
+{
+    return (const char *)fs + file->name;
+}
+
+const void *
+romfs_file(const struct romfs *fs, const char *name, uint32_t *len)
+{
+    const struct romfs_entry *file = romfs_find(fs, name);
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    if (len) {
+        *len = file->length;
+    }
+
+    return romfs_data(fs, file);
+}
+
+int
+romfs_verify(const struct romfs *fs, const struct romfs_entry *file)
+{
+    return crc32(0, romfs_data(fs, file), file->length) == file->crc ? 0 : -1;
+}
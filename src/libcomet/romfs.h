@@ -0,0 +1,72 @@
+#ifndef ROMFS_H
+#define ROMFS_H
+
+#include <stdint.h>
+#include "part.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Read only filesystem in ROM
+ *
+ * romfs.py (in COMET68k_bootloader) builds a filesystem image from a directory
+ * of lookup tables, fonts, configuration and so on, and make_image.py places it
+ * in a romfs partition, usually in ROM0. Files are found by name, and their
+ * contents used where they are in ROM: nothing is copied, and no RAM is
+ * needed. Contents start on a multiple of 4 bytes, so may be cast to tables of
+ * 16 or 32 bit values.
+ *
+ * romfs_open() checks the directory. The contents of each file have their own
+ * CRC32, which romfs_verify() checks, as it takes a while for large files. */
+
+#define ROMFS_MAGIC 0x43524653      /* "CRFS" */
+#define ROMFS_VERSION 1
+#define ROMFS_ALIGN 4
+
+struct romfs_entry {
+    uint32_t name;                  /* Offset of the name, terminated by a
+                                     * zero byte */
+    uint32_t offset;                /* Offset of the contents */
+    uint32_t length;
+    uint32_t crc;                   /* CRC32 of the contents */
+};
+
+struct romfs {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;                  /* Size of the whole image */
+    uint32_t crc;                   /* CRC32 of the entries and names */
+    struct romfs_entry entries[];   /* Sorted by name */
+};
+
+/* Check the filesystem image at base, no longer than size bytes. Returns NULL
+ * if it is not valid. */
+const struct romfs *romfs_open(const void *base, uint32_t size);
+
+/* Open the filesystem in the named partition of the ROM image at rom, e.g.
+ * romfs_open_part(PART_ROM0, "assets") */
+const struct romfs *romfs_open_part(uintptr_t rom, const char *name);
+
+/* Find a file by its full name, e.g. "fonts/8x16.fnt". Returns NULL if there
+ * is no such file. */
+const struct romfs_entry *romfs_find(const struct romfs *fs, const char *name);
+
+/* Address of a file's contents in ROM, and its name */
+const void *romfs_data(const struct romfs *fs, const struct romfs_entry *file);
+const char *romfs_name(const struct romfs *fs, const struct romfs_entry *file);
+
+/* Find a file, returning the address of its contents and setting *len to its
+ * length, or returning NULL if there is no such file */
+const void *romfs_file(const struct romfs *fs, const char *name,
+                       uint32_t *len);
+
+/* Returns 0 if the CRC32 of a file's contents is correct */
+int romfs_verify(const struct romfs *fs, const struct romfs_entry *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROMFS_H */
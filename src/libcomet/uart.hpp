@@ -0,0 +1,102 @@
+#ifndef UART_HPP
+#define UART_HPP
+
+#include <stdint.h>
+#include "TL16C2552.h"
+#include "TL16C2552.hpp"
+#include "mmio.hpp"
+
+/* Driver for a channel of the TL16C2552 dual UART, as an example of a driver
+ * written with mmio.hpp
+ *
+ * The channel's base address and input clock are template parameters, so each
+ * channel is its own type, and everything about it is resolved when compiling.
+ * The baud rate divisor is worked out by the compiler, which also checks that
+ * the clock can make the baud rate exactly. put() compiles to the same
+ * instructions as uart_send_char() in the bootloader.
+ *
+ *   uart_a::init<230400>();
+ *   uart_a::put('A');
+ */
+
+template <uintptr_t Base, uint32_t Clock = 7372800>
+class tl16c2552_channel {
+    using rbr = mmio::reg<Base + UART_RBR_REG>;
+    using thr = mmio::reg<Base + UART_THR_REG>;
+    using ier = tl16c2552::uartier<Base + UART_IER_REG>;
+    using fcr = tl16c2552::uartfcr<Base + UART_FCR_REG>;
+    using lcr = tl16c2552::uartlcr<Base + UART_LCR_REG>;
+    using lsr = tl16c2552::uartlsr<Base + UART_LSR_REG>;
+    using dll = mmio::reg<Base + UART_DLL_REG>;
+    using dlm = mmio::reg<Base + UART_DLM_REG>;
+
+public:
+    /* 8 data bits, no parity, 1 stop bit, FIFOs enabled */
+    template <uint32_t Baud>
+    static void
+    init()
+    {
+        constexpr uint32_t divisor = Clock / (16 * Baud);
+
+        static_assert(divisor > 0 && divisor <= 0xFFFF,
+                      "Baud rate out of range for the UART clock");
+        static_assert(Clock / (16 * divisor) == Baud,
+                      "Baud rate cannot be made exactly from the UART clock");
+
+        /* Each register is written once */
+        lcr::write(lcr::dlab(1) | lcr::wlen(3));
+        dll::write(divisor & 0xFF);
+        dlm::write(divisor >> 8);
+        lcr::write(lcr::wlen(3));
+
+        /* Reset FIFOs and enable tx and rx */
+        fcr::write(fcr::rxrst(1) | fcr::txrst(1) | fcr::en(1));
+    }
+
+    static bool
+    readable()
+    {
+        return lsr::rxd.read();
+    }
+
+    static uint8_t
+    get()
+    {
+        while (!readable());
+
+        return rbr::read();
+    }
+
+    static void
+    put(uint8_t data)
+    {
+        while (!lsr::thre.read());  /* Wait for the transmit FIFO to empty */
+
+        thr::write(data);
+    }
+
+    static void
+    put(const char *str)
+    {
+        while (*str) {
+            put(static_cast<uint8_t>(*str++));
+        }
+    }
+
+    static void
+    irq_enable(uint8_t bits)
+    {
+        ier::set(bits);
+    }
+
+    static void
+    irq_disable(uint8_t bits)
+    {
+        ier::clear(bits);
+    }
+};
+
+using uart_a = tl16c2552_channel<UART_BASE + UART_CHA>;
+using uart_b = tl16c2552_channel<UART_BASE>;
+
+#endif /* UART_HPP */
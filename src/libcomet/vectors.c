@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include "cpu.h"
+#include "vectors.h"
+
+vector_t *
+vector_table(void)
+{
+#if defined(__mc68010__)
+    vector_t *vbr;
+
+    __asm__ volatile (
+        "movec %%vbr, %0"
+        : "=r" (vbr)
+    );
+
+    return vbr;
+#else
+    vector_t *table;
+
+    /* The 68000 always fetches vectors from address 0. This is hidden from the
+     * compiler, which would otherwise treat accesses to the table as null
+     * pointer dereferences. */
+    __asm__ (
+        "suba.l %0, %0"
+        : "=a" (table)
+    );
+
+    return table;
+#endif
+}
+
+vector_t
+vector_install(uint16_t vector, vector_t handler)
+{
+    vector_t *table = vector_table();
+    vector_t old;
+    uint16_t sr;
+
+    if (vector >= VEC_COUNT) {
+        return 0;
+    }
+
+    /* The entry is written with a single move.l, but a handler that replaces
+     * the same vector (as probe_read8() does the bus error vector) could run
+     * between reading the old entry and writing the new one. Its handler would
+     * then be lost, and the one returned here would be stale. */
+    sr = irq_save();
+
+    old = table[vector];
+    table[vector] = handler;
+
+    irq_restore(sr);
+
+    return old;
+}
+
+vector_t
+vector_get(uint16_t vector)
+{
+    if (vector >= VEC_COUNT) {
+        return 0;
+    }
+
+    return vector_table()[vector];
+}
@@ -0,0 +1,60 @@
+#ifndef VECTORS_H
+#define VECTORS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exception vectors in RAM
+ *
+ * With ROMRAM_REMAP defined in crt0.S, the exception vector table is copied from
+ * ROM to the start of DRAM at reset (or wherever the VBR points on a 68010), and
+ * the CPU fetches every vector from there. vector_install() replaces an entry
+ * in that table, so drivers can hook interrupts without the vector having to be
+ * defined when the program is linked.
+ *
+ * Each entry points straight at its handler, so there is no extra cost to an
+ * interrupt beyond the vector fetch. Handlers written in C must be declared
+ * with ISR, so that they save the registers they use and return with rte.
+ * Marking them FASTTEXT as well (see fast.h) runs them from DRAM. */
+
+/* Vector numbers */
+#define VEC_BUS_ERROR 2
+#define VEC_ADDRESS_ERROR 3
+#define VEC_ILLEGAL_INSTRUCTION 4
+#define VEC_ZERO_DIVIDE 5
+#define VEC_CHK_INSTRUCTION 6
+#define VEC_TRAPV_INSTRUCTION 7
+#define VEC_PRIVILEGE_VIOLATION 8
+#define VEC_TRACE 9
+#define VEC_LINE_1010 10
+#define VEC_LINE_1111 11
+#define VEC_FORMAT_ERROR 14
+#define VEC_UNINITIALIZED 15
+#define VEC_SPURIOUS 24
+#define VEC_IRQ(n) (24 + (n))       /* Autovectored interrupt level 1-7 */
+#define VEC_TRAP(n) (32 + (n))      /* TRAP #0-15 */
+#define VEC_USER(n) (64 + (n))      /* User interrupt vectors 0-191 */
+
+#define VEC_COUNT 256
+
+#define ISR __attribute__((interrupt_handler))
+
+typedef void (*vector_t)(void);
+
+/* Install handler for vector, returning the handler it replaces */
+vector_t vector_install(uint16_t vector, vector_t handler);
+
+/* Return the handler currently installed for vector */
+vector_t vector_get(uint16_t vector);
+
+/* Return the address of the vector table in use */
+vector_t *vector_table(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VECTORS_H */
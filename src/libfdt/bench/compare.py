@@ -0,0 +1,111 @@
+# Compare results of the libfdt benchmark side by side
+#
+# Each file is the output of fdtbench with -j, or of the 68000 build as
+# captured from loader4.py, with one JSON object per line. Each query is given
+# a row, and each file a column, headed by the FDT_ASSUME_MASK level it was
+# built with, and for the 68000 whether values were used in native byte order.
+# Times are nanoseconds on the host, or CPU cycles on the 68000, and each after
+# the first is followed by its change from the first. Where a file holds more
+# than one result for a query, from repeated runs, the fastest is used.
+#
+#   python3 compare.py results-0.json results-ff.json
+
+import argparse
+import json
+import sys
+
+
+def read_results(filename: str) -> dict:
+    """ Read one set of results, keyed by (tree, nodes, query) """
+    results = {}
+
+    with open(filename, 'r') as f:
+        for line in f:
+            line = line.strip()
+
+            # Anything else the target printed, e.g. "done"
+            if not line.startswith('{'):
+                continue
+
+            rec = json.loads(line)
+            key = (rec['tree'], rec['nodes'], rec['query'])
+
+            if 'error' in rec:
+                print(f'{filename}: {rec["tree"]} {rec["query"]}: '
+                      f'{rec["error"]}', file=sys.stderr)
+                continue
+
+            unit = 'ns' if 'ns' in rec else 'cycles'
+            label = f'0x{rec["assume"]:02x}'
+
+            if 'endian' in rec:
+                label += f' {rec["endian"]}'
+
+            if key not in results or rec[unit] < results[key][1]:
+                results[key] = (label, rec[unit], unit)
+
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare libfdt benchmark results side by side'
+    )
+    parser.add_argument(
+        'files',
+        type=str, nargs='+',
+        help='Results, one JSON object per line'
+    )
+    args = parser.parse_args()
+
+    sets = [read_results(filename) for filename in args.files]
+    keys = []
+
+    for results in sets:
+        for key in results:
+            if key not in keys:
+                keys.append(key)
+
+    heads = []
+
+    for filename, results in zip(args.files, sets):
+        if results:
+            label, _, unit = next(iter(results.values()))
+            heads.append(f'{label} {unit}')
+        else:
+            heads.append(filename)
+
+    print(f'{"tree":24} {"nodes":>6}  {"query":20}' +
+          ''.join(f' {head:>20}' for head in heads))
+
+    for key in keys:
+        tree, nodes, query = key
+        line = f'{tree[-24:]:24} {nodes:6}  {query:20}'
+        first = None
+
+        for results in sets:
+            if key not in results:
+                line += f' {"-":>20}'
+                continue
+
+            val = results[key][1]
+
+            if first is None:
+                first = val
+                line += f' {val:20.1f}'
+            elif first:
+                line += f' {val:11.1f} ({(val - first) * 100 / first:+5.0f}%)'
+            else:
+                line += f' {val:20.1f}'
+
+        print(line)
+
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except (OSError, ValueError, KeyError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
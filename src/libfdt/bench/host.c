@@ -0,0 +1,176 @@
+/* libfdt benchmark, host build. See README.md.
+ *
+ *   ./fdtbench-0 [-j] [-n nodes,...] [-p path] [file.dtb ...]
+ *
+ * Runs the suite over each blob given, then over synthetic trees of the given
+ * numbers of nodes. Blobs are looked up at the path of the DP8570A in
+ * COMET68k.dts unless -p gives another. Results are written as a table, or
+ * with -j as one JSON object per line for compare.py. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <libfdt.h>
+#include "COMET68k.h"
+#include "suite.h"
+
+#define DEFAULT_NODES "16,64,256,1024"
+
+static int json;
+
+uint32_t
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec;
+}
+
+uint32_t
+bench_elapsed(uint32_t start)
+{
+    return bench_now() - start;
+}
+
+void
+bench_report(const struct bench_tree *tree, const char *query, uint32_t total)
+{
+    double ns = (double)total / BENCH_CALLS;
+
+    if (json) {
+        printf("{\"tree\": \"%s\", \"nodes\": %u, \"assume\": %d, "
+               "\"query\": \"%s\", \"ns\": %.1f}\n",
+               tree->name, tree->nodes, FDT_ASSUME_MASK, query, ns);
+    } else {
+        printf("%-24s %6u  %-20s %10.1f ns\n",
+               tree->name, tree->nodes, query, ns);
+    }
+}
+
+void
+bench_fail(const struct bench_tree *tree, const char *query, int result)
+{
+    fprintf(stderr, "%s: %s gave %d (%s)\n", tree->name, query, result,
+            result < 0 ? fdt_strerror(result) : "wrong offset");
+}
+
+static void *
+read_blob(const char *filename, uint32_t *avail, uint32_t *nodes)
+{
+    FILE *f = fopen(filename, "rb");
+    void *blob;
+    long size;
+    int offset;
+    int depth = 0;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0) {
+        perror(filename);
+        exit(1);
+    }
+
+    rewind(f);
+    blob = malloc(size);
+
+    if (blob == NULL || fread(blob, 1, size, f) != (size_t)size) {
+        perror(filename);
+        exit(1);
+    }
+
+    fclose(f);
+    *avail = size;
+
+    if (fdt_check_full(blob, size) < 0) {
+        fprintf(stderr, "%s: not a valid devicetree blob\n", filename);
+        exit(1);
+    }
+
+    *nodes = 0;
+
+    for (offset = 0; offset >= 0;
+         offset = fdt_next_node(blob, offset, &depth)) {
+        (*nodes)++;
+    }
+
+    return blob;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *nodes = DEFAULT_NODES;
+    const char *path = DT_TIMER0_PATH;
+    struct bench_tree tree;
+    char name[32];
+    void *buf;
+    int bufsize;
+    int err;
+    int opt;
+    char *p;
+
+    while ((opt = getopt(argc, argv, "jn:p:")) != -1) {
+        switch (opt) {
+            case 'j':
+                json = 1;
+                break;
+
+            case 'n':
+                nodes = optarg;
+                break;
+
+            case 'p':
+                path = optarg;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-j] [-n nodes,...] [-p path] "
+                        "[file.dtb ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (!json) {
+        printf("FDT_ASSUME_MASK 0x%02x, %d calls each\n", FDT_ASSUME_MASK,
+               BENCH_CALLS);
+    }
+
+    for (; optind < argc; optind++) {
+        tree.name = argv[optind];
+        tree.fdt = read_blob(argv[optind], &tree.size, &tree.nodes);
+        tree.path = path;
+        bench_run(&tree);
+        free((void *)tree.fdt);
+    }
+
+    for (p = (char *)nodes; *p; p += (*p == ',')) {
+        tree.nodes = strtoul(p, &p, 0);
+
+        if (tree.nodes == 0 || (*p && *p != ',')) {
+            fprintf(stderr, "Bad number of nodes: %s\n", nodes);
+            return 1;
+        }
+
+        /* About 100 bytes a node */
+        bufsize = 1024 + tree.nodes * 128;
+        buf = malloc(bufsize);
+        err = bench_synth(buf, bufsize, tree.nodes, &tree);
+
+        if (err) {
+            fprintf(stderr, "synthetic tree: %s\n", fdt_strerror(err));
+            return 1;
+        }
+
+        snprintf(name, sizeof(name), "synthetic-%u", tree.nodes);
+        tree.name = name;
+        bench_run(&tree);
+        free(buf);
+    }
+
+    return 0;
+}
@@ -0,0 +1,370 @@
+#include <stdint.h>
+#include <string.h>
+#include <libfdt.h>
+#include "fdt_index.h"
+#include "fdt_phandle_cache.h"
+#include "suite.h"
+
+/* Devices on each bus of a synthetic tree */
+#define SYNTH_DEVICES 15
+
+/* Room in the phandle cache, for every node of the largest synthetic tree */
+#ifndef BENCH_PHANDLES
+#define BENCH_PHANDLES 1100
+#endif
+
+static struct fdt_phandle_entry phandles[BENCH_PHANDLES];
+static struct fdt_phandle_cache cache;
+
+/* What the queries look for, worked out from the node given by the tree's
+ * path before any are timed */
+static struct {
+    const void *fdt;
+    const struct fdt_index *idx;
+    const char *path;
+    const char *compatible;
+    const char *prop;
+    uint32_t phandle;
+} q;
+
+static int
+q_none(void)
+{
+    return 0;
+}
+
+static int
+q_path_offset(void)
+{
+    return fdt_path_offset(q.fdt, q.path);
+}
+
+static int
+q_index_path_offset(void)
+{
+    return fdt_index_path_offset(q.fdt, q.idx, q.path);
+}
+
+static int
+q_getprop(void)
+{
+    int len;
+
+    if (fdt_getprop(q.fdt, fdt_path_offset(q.fdt, q.path), q.prop, &len)) {
+        return len;
+    }
+
+    return len < 0 ? len : -1;
+}
+
+static int
+q_by_compatible(void)
+{
+    return fdt_node_offset_by_compatible(q.fdt, -1, q.compatible);
+}
+
+static int
+q_index_by_compatible(void)
+{
+    return fdt_index_node_offset_by_compatible(q.fdt, q.idx, -1, q.compatible);
+}
+
+static int
+q_by_phandle(void)
+{
+    return fdt_node_offset_by_phandle(q.fdt, q.phandle);
+}
+
+static int
+q_index_by_phandle(void)
+{
+    return fdt_index_node_offset_by_phandle(q.fdt, q.idx, q.phandle);
+}
+
+static int
+q_cache_init(void)
+{
+    return fdt_phandle_cache_init(&cache, q.fdt, phandles, BENCH_PHANDLES);
+}
+
+static int
+q_cache_by_phandle(void)
+{
+    return fdt_phandle_cache_lookup(&cache, q.fdt, q.phandle);
+}
+
+static int
+q_check_full(void)
+{
+    return fdt_check_full(q.fdt, fdt_totalsize(q.fdt));
+}
+
+/* Flags of queries that need something the tree may not have */
+#define NEEDS_INDEX 1
+#define NEEDS_PHANDLE 2
+
+static const struct {
+    const char *name;
+    int (*fn)(void);
+    uint8_t needs;
+} queries[] = {
+    { "path_offset", q_path_offset, 0 },
+    { "index_path_offset", q_index_path_offset, NEEDS_INDEX },
+    { "getprop", q_getprop, 0 },
+    { "by_compatible", q_by_compatible, 0 },
+    { "index_by_compatible", q_index_by_compatible, NEEDS_INDEX },
+    { "by_phandle", q_by_phandle, NEEDS_PHANDLE },
+    { "index_by_phandle", q_index_by_phandle, NEEDS_INDEX | NEEDS_PHANDLE },
+    { "cache_init", q_cache_init, NEEDS_PHANDLE },
+    { "cache_by_phandle", q_cache_by_phandle, NEEDS_PHANDLE },
+    { "check_full", q_check_full, 0 },
+};
+
+#define QUERIES (sizeof(queries) / sizeof(queries[0]))
+
+static uint32_t
+time_calls(int (*fn)(void))
+{
+    uint32_t best = UINT32_MAX;
+    uint32_t total;
+    uint32_t start;
+    uint32_t ctr;
+    uint8_t run;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+#ifdef BENCH_PER_CALL
+        total = 0;
+
+        for (ctr = 0; ctr < BENCH_CALLS; ctr++) {
+            start = bench_now();
+            fn();
+            total += bench_elapsed(start);
+        }
+#else
+        start = bench_now();
+
+        for (ctr = 0; ctr < BENCH_CALLS; ctr++) {
+            fn();
+        }
+
+        total = bench_elapsed(start);
+#endif
+
+        if (total < best) {
+            best = total;
+        }
+    }
+
+    return best;
+}
+
+void
+bench_run(const struct bench_tree *tree)
+{
+    const char *name;
+    uint32_t overhead;
+    uint32_t total;
+    uint8_t have = 0;
+    uint8_t ctr;
+    int count = 0;
+    int expect;
+    int result;
+    int node;
+    int prop;
+
+    q.fdt = tree->fdt;
+    q.idx = fdt_index_get(q.fdt, tree->size);
+    q.path = tree->path;
+    q.compatible = NULL;
+    q.prop = NULL;
+    q.phandle = 0;
+
+    node = fdt_path_offset(q.fdt, q.path);
+
+    if (node < 0) {
+        bench_fail(tree, "path", node);
+
+        return;
+    }
+
+    q.compatible = fdt_stringlist_get(q.fdt, node, "compatible", 0, NULL);
+    q.phandle = fdt_get_phandle(q.fdt, node);
+
+    /* The last property takes longest to find */
+    fdt_for_each_property_offset(prop, q.fdt, node) {
+        fdt_getprop_by_offset(q.fdt, prop, &q.prop, NULL);
+    }
+
+    if (q.compatible == NULL || q.prop == NULL) {
+        bench_fail(tree, "compatible", -FDT_ERR_NOTFOUND);
+
+        return;
+    }
+
+    if (q.idx) {
+        have |= NEEDS_INDEX;
+    }
+
+    if (q.phandle) {
+        have |= NEEDS_PHANDLE;
+    }
+
+    /* Nodes with phandles, for the cache */
+    for (node = 0; node >= 0; node = fdt_next_node(q.fdt, node, NULL)) {
+        count += fdt_get_phandle(q.fdt, node) != 0;
+    }
+
+    node = fdt_path_offset(q.fdt, q.path);
+
+    overhead = time_calls(q_none);
+
+    for (ctr = 0; ctr < QUERIES; ctr++) {
+        if ((queries[ctr].needs & have) != queries[ctr].needs) {
+            continue;
+        }
+
+        name = queries[ctr].name;
+
+        /* Check the answer first, as a query that fails early would look
+         * fast. The compatible string is the node's own, so the node is the
+         * first with it only if no earlier node shares it. */
+        if (queries[ctr].fn == q_getprop) {
+            fdt_getprop(q.fdt, node, q.prop, &expect);
+        } else if (queries[ctr].fn == q_check_full) {
+            expect = 0;
+        } else if (queries[ctr].fn == q_cache_init) {
+            expect = count;
+        } else if (queries[ctr].fn == q_by_compatible ||
+                   queries[ctr].fn == q_index_by_compatible) {
+            expect = fdt_node_offset_by_compatible(q.fdt, -1, q.compatible);
+        } else {
+            expect = node;
+        }
+
+        result = queries[ctr].fn();
+
+        if (result != expect) {
+            bench_fail(tree, name, result);
+
+            continue;
+        }
+
+        total = time_calls(queries[ctr].fn);
+        bench_report(tree, name, total > overhead ? total - overhead : 0);
+    }
+
+    fdt_phandle_cache_release(&cache);
+}
+
+/* Copy a string, returning the end of the copy (at its terminator) */
+static char *
+append(char *p, const char *str)
+{
+    while (*str) {
+        *p++ = *str++;
+    }
+
+    *p = '\0';
+
+    return p;
+}
+
+/* Append a number in hex, as the 68000 may have no printf to do it */
+static char *
+append_hex(char *p, uint32_t val)
+{
+    static const char hex[] = "0123456789abcdef";
+    int8_t shift;
+
+    for (shift = 28; shift > 0 && (val >> shift) == 0; shift -= 4);
+
+    for (; shift >= 0; shift -= 4) {
+        *p++ = hex[(val >> shift) & 0xF];
+    }
+
+    *p = '\0';
+
+    return p;
+}
+
+int
+bench_synth(void *buf, int bufsize, uint32_t nodes, struct bench_tree *tree)
+{
+    static char path[48];
+    char name[24];
+    char compat[32];
+    fdt32_t reg[2];
+    uint32_t buses;
+    uint32_t bus;
+    uint32_t dev;
+    uint32_t addr;
+    uint32_t phandle = 1;
+    char *p;
+    int err;
+
+    /* Each bus is a node with SYNTH_DEVICES under it, plus the root */
+    buses = nodes / (SYNTH_DEVICES + 1);
+
+    if (buses == 0) {
+        buses = 1;
+    }
+
+    tree->nodes = 1 + buses * (SYNTH_DEVICES + 1);
+    tree->fdt = buf;
+    tree->size = 0;
+    tree->path = path;
+
+    err = fdt_create(buf, bufsize);
+    err = err ? err : fdt_finish_reservemap(buf);
+    err = err ? err : fdt_begin_node(buf, "");
+    err = err ? err : fdt_property_string(buf, "model", "synthetic");
+    err = err ? err : fdt_property_cell(buf, "#address-cells", 1);
+    err = err ? err : fdt_property_cell(buf, "#size-cells", 1);
+
+    for (bus = 0; bus < buses && !err; bus++) {
+        addr = 0x100000 * (bus + 1);
+        append_hex(append(name, "bus@"), addr);
+        err = fdt_begin_node(buf, name);
+        err = err ? err : fdt_property(buf, "compatible", "simple-bus",
+                                       sizeof("simple-bus"));
+        err = err ? err : fdt_property_cell(buf, "#address-cells", 1);
+        err = err ? err : fdt_property_cell(buf, "#size-cells", 1);
+        err = err ? err : fdt_property(buf, "ranges", NULL, 0);
+        err = err ? err : fdt_property_cell(buf, "phandle", phandle++);
+
+        for (dev = 0; dev < SYNTH_DEVICES && !err; dev++) {
+            /* Each device has a compatible string of its own, then one
+             * shared with every other device, e.g. "acme,dev1f\0generic" */
+            addr += 0x100;
+            append_hex(append(name, "dev@"), addr);
+            p = append_hex(append(compat, "acme,dev"),
+                           bus * SYNTH_DEVICES + dev);
+            p = append(p + 1, "generic");
+            reg[0] = cpu_to_fdt32(addr);
+            reg[1] = cpu_to_fdt32(0x100);
+
+            err = fdt_begin_node(buf, name);
+            err = err ? err : fdt_property(buf, "compatible", compat,
+                                           p - compat + 1);
+            err = err ? err : fdt_property(buf, "reg", reg, sizeof(reg));
+            err = err ? err : fdt_property_cell(buf, "interrupts", dev + 1);
+            err = err ? err : fdt_property_string(buf, "status", "okay");
+            err = err ? err : fdt_property_cell(buf, "phandle", phandle++);
+            err = err ? err : fdt_end_node(buf);
+        }
+
+        err = err ? err : fdt_end_node(buf);
+    }
+
+    err = err ? err : fdt_end_node(buf);
+    err = err ? err : fdt_finish(buf);
+
+    if (!err) {
+        /* The last device on the last bus is the furthest to walk to */
+        p = append_hex(append(path, "/bus@"), 0x100000 * buses);
+        append_hex(append(p, "/dev@"),
+                   0x100000 * buses + 0x100 * SYNTH_DEVICES);
+    }
+
+    return err;
+}
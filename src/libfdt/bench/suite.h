@@ -0,0 +1,67 @@
+#ifndef SUITE_H
+#define SUITE_H
+
+/* libfdt benchmark suite, shared by the host (host.c) and the 68000
+ * (target.c). See README.md.
+ *
+ * The suite runs each query over a tree a number of times and passes the
+ * total time to the platform to report. This is repeated a few times, and the
+ * fastest run is the one reported, as anything else going on (other
+ * processes, interrupts, caches not yet warm) only ever slows a run down.
+ * Times are in whatever units the platform counts in: nanoseconds on the host,
+ * CPU cycles on the 68000. */
+
+#include <stdint.h>
+
+/* Calls of each query to time. A power of 2, so that the 68000 can divide by
+ * it with a shift. */
+#ifndef BENCH_CALLS
+#define BENCH_CALLS 1024
+#endif
+
+/* Runs of BENCH_CALLS calls, of which the fastest is reported */
+#ifndef BENCH_RUNS
+#define BENCH_RUNS 5
+#endif
+
+/* Level of assumptions libfdt was built with, as in libfdt_internal.h */
+#ifndef FDT_ASSUME_MASK
+#define FDT_ASSUME_MASK 0
+#endif
+
+/* Define BENCH_PER_CALL to time each call on its own rather than all of them
+ * at once, for a clock that must be read often to be read correctly */
+
+struct bench_tree {
+    const char *name;
+    const void *fdt;
+    uint32_t size;          /* Bytes that may be read from fdt, including any
+                             * index after the blob, or 0 for no index */
+    uint32_t nodes;
+    const char *path;       /* Node to look up. Its first compatible string,
+                             * last property and phandle (if any) are looked
+                             * up too. */
+};
+
+/* Provided by the platform. bench_now() is any point in time, and
+ * bench_elapsed() the time since it. */
+uint32_t bench_now(void);
+uint32_t bench_elapsed(uint32_t start);
+
+/* Called with the total time of BENCH_CALLS calls of a query, in the fastest
+ * of BENCH_RUNS runs, less the time taken to time an empty one */
+void bench_report(const struct bench_tree *tree, const char *query,
+                  uint32_t total);
+
+/* Called when a query gives the wrong answer, which is not timed */
+void bench_fail(const struct bench_tree *tree, const char *query, int result);
+
+/* Build a tree of about the given number of nodes in buf, of devices spread
+ * over a number of buses. Returns 0, or a libfdt error. */
+int bench_synth(void *buf, int bufsize, uint32_t nodes,
+                struct bench_tree *tree);
+
+/* Run every query over a tree */
+void bench_run(const struct bench_tree *tree);
+
+#endif /* SUITE_H */
@@ -0,0 +1,160 @@
+/* libfdt benchmark, 68000 build. See README.md.
+ *
+ * Loaded into DRAM and run by the bootloader:
+ *
+ *   python3 loader4.py --log fdtbench-68000-0.elf
+ *
+ * Each query is timed with timer 0 of the DP8570A, and the results written to
+ * UART channel A as one JSON object per line, in cycles of the CPU clock. */
+
+#include <stdint.h>
+#include <libfdt.h>
+#include "COMET68k.h"
+#include "DP8570A.h"
+#include "TL16C2552.h"
+#include "bootprof.h"
+#include "console.h"
+#include "suite.h"
+
+/* The timer counts at 625kHz, so each tick is 16 cycles of the 10MHz CPU
+ * clock and a single call is timed to within 16 cycles. BENCH_CALLS calls
+ * are averaged. */
+#define CYCLES_PER_TICK (DT_CPU0_CLOCK_FREQUENCY / DT_TIMER0_CLOCK_FREQUENCY)
+
+/* Room for the largest synthetic tree, at about 100 bytes a node */
+#define SYNTH_BUF (1024 + 256 * 128)
+
+/* COMET68k.dtb with its index, from start.S */
+extern const char comet68k_dtb[];
+extern const char comet68k_dtb_end[];
+
+static const uint16_t synth_nodes[] = { 16, 64, 256 };
+
+static uint8_t synth_buf[SYNTH_BUF] __attribute__((aligned(4)));
+
+static void
+init_uart(void)
+{
+    /* As the bootloader, which is reset before running a program */
+    __UARTLCRbits_t lcr = { .u8 = 0 };
+
+    lcr.WLEN = 3;                   /* 8 bits per byte */
+    lcr.DLAB = 1;
+    UALCR = lcr.u8;
+    UADLL = 2;                      /* 230400 baud */
+    UADLM = 0;
+
+    lcr.DLAB = 0;
+    UALCR = lcr.u8;
+
+    UAFCR = 0x7;
+}
+
+static void
+init_timer(void)
+{
+    /* As crt0.S does at reset, so that the timer runs even when the
+     * bootloader was built without BOOT_PROFILE */
+    TMSR = TIMER_MSR_T0;
+    TT0CR = TIMER_TCR_CLK_EXT | TIMER_TCR_MODE1;
+    TT0LSB = 0xFF;
+    TT0MSB = 0xFF;
+    TT0CR = TIMER_TCR_CLK_EXT | TIMER_TCR_MODE1 | TIMER_TCR_TSS;
+
+    bootprof_init();
+}
+
+uint32_t
+bench_now(void)
+{
+    return bootprof_now();
+}
+
+uint32_t
+bench_elapsed(uint32_t start)
+{
+    return ((bootprof_now() - start) & 0xFFFFFF) * CYCLES_PER_TICK;
+}
+
+static void
+put_head(const struct bench_tree *tree, const char *query)
+{
+    console_puts("{\"tree\": \"", 0);
+    console_puts(tree->name, 0);
+    console_puts("\", \"nodes\": ", 0);
+    console_putdec(tree->nodes, 0);
+    console_puts(", \"assume\": ", 0);
+    console_putdec(FDT_ASSUME_MASK, 0);
+#ifdef FDT_NATIVE_ENDIAN
+    console_puts(", \"endian\": \"native\"", 0);
+#else
+    console_puts(", \"endian\": \"bytes\"", 0);
+#endif
+    console_puts(", \"query\": \"", 0);
+    console_puts(query, 0);
+    console_puts("\", ", 0);
+}
+
+void
+bench_report(const struct bench_tree *tree, const char *query, uint32_t total)
+{
+    put_head(tree, query);
+    console_puts("\"cycles\": ", 0);
+    console_putdec(total / BENCH_CALLS, 0);
+    console_puts("}\r\n", 0);
+}
+
+void
+bench_fail(const struct bench_tree *tree, const char *query, int result)
+{
+    put_head(tree, query);
+    console_puts("\"error\": \"", 0);
+    console_puts(result < 0 ? fdt_strerror(result) : "wrong offset", 0);
+    console_puts("\"}\r\n", 0);
+}
+
+int
+main(void)
+{
+    static const char *const names[] = {
+        "synthetic-17", "synthetic-65", "synthetic-257"
+    };
+    struct bench_tree tree;
+    int offset;
+    int depth = 0;
+    uint8_t ctr;
+    int err;
+
+    init_uart();
+    init_timer();
+
+    tree.name = "COMET68k.dtb";
+    tree.fdt = comet68k_dtb;
+    tree.size = comet68k_dtb_end - comet68k_dtb;
+    tree.path = DT_TIMER0_PATH;
+    tree.nodes = 0;
+
+    for (offset = 0; offset >= 0;
+         offset = fdt_next_node(tree.fdt, offset, &depth)) {
+        tree.nodes++;
+    }
+
+    bench_run(&tree);
+
+    for (ctr = 0; ctr < sizeof(synth_nodes) / sizeof(synth_nodes[0]); ctr++) {
+        err = bench_synth(synth_buf, sizeof(synth_buf), synth_nodes[ctr],
+                          &tree);
+        tree.name = names[ctr];
+
+        if (err) {
+            bench_fail(&tree, "synthetic", err);
+            continue;
+        }
+
+        bench_run(&tree);
+    }
+
+    console_puts("done\r\n", 0);
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * Lookup index for devicetree blobs in ROM, see fdt_index.h
+ */
+#include "libfdt_env.h"
+
+#include <fdt.h>
+#include <libfdt.h>
+
+#include "libfdt_internal.h"
+#include "fdt_index.h"
+
+#define FNV_BASIS	0x811c9dc5
+
+/*
+ * 32 bit FNV-1a. The multiplication by the FNV prime (0x01000193) is done
+ * with shifts and adds, as the 68000 has no 32 bit multiply.
+ */
+static uint32_t fdt_index_hash_(uint32_t h, const char *s, int len)
+{
+	while (len--) {
+		h ^= (uint8_t)*s++;
+		h += (h << 1) + (h << 4) + (h << 7) + (h << 8) + (h << 24);
+	}
+
+	return h;
+}
+
+const struct fdt_index *fdt_index_get(const void *fdt, size_t avail)
+{
+	const struct fdt_index *idx;
+	size_t start;
+	uint32_t offset;
+	uint32_t slots;
+	int t;
+
+	if (fdt_magic(fdt) != FDT_MAGIC)
+		return NULL;
+
+	start = FDT_TAGALIGN(fdt_totalsize(fdt));
+
+	if (start > avail || avail - start < sizeof(*idx))
+		return NULL;
+
+	idx = (const struct fdt_index *)((const char *)fdt + start);
+	avail -= start;
+
+	if (fdt32_to_cpu(idx->magic) != FDT_INDEX_MAGIC ||
+	    fdt16_to_cpu(idx->version) != FDT_INDEX_VERSION ||
+	    fdt32_to_cpu(idx->totalsize) != fdt_totalsize(fdt) ||
+	    fdt32_to_cpu(idx->size_dt_struct) != fdt_size_dt_struct(fdt))
+		return NULL;
+
+	/* Every slot that a lookup may read must be within avail too */
+	for (t = 0; t < FDT_INDEX_TABLES; t++) {
+		offset = fdt32_to_cpu(idx->table[t].offset);
+		slots = fdt32_to_cpu(idx->table[t].slots);
+
+		if (slots == 0 || (slots & (slots - 1)) || offset > avail ||
+		    (avail - offset) / sizeof(struct fdt_index_slot) < slots)
+			return NULL;
+	}
+
+	return idx;
+}
+
+/*
+ * Walk the slots of a table that may hold key, starting from the slot
+ * the key hashes to and stopping at an empty one. *pos is -1 to start,
+ * and the value of each slot with the key is returned in turn, then -1.
+ */
+static int fdt_index_next_(const struct fdt_index *idx, int table,
+			   uint32_t key, int *pos)
+{
+	const struct fdt_index_slot *slots;
+	uint32_t mask = fdt32_to_cpu(idx->table[table].slots) - 1;
+	uint32_t i;
+	uint32_t value;
+
+	slots = (const struct fdt_index_slot *)((const char *)idx +
+			fdt32_to_cpu(idx->table[table].offset));
+
+	while ((uint32_t)++*pos <= mask) {
+		i = (key + *pos) & mask;
+		value = fdt32_to_cpu(slots[i].value);
+
+		if (value == FDT_INDEX_EMPTY)
+			break;
+
+		if (fdt32_to_cpu(slots[i].key) == key)
+			return value;
+	}
+
+	return -1;
+}
+
+/* Last component of a path */
+static const char *fdt_index_basename_(const char *path)
+{
+	const char *p = strrchr(path, '/');
+
+	return p ? p + 1 : path;
+}
+
+int fdt_index_path_offset(const void *fdt, const struct fdt_index *idx,
+			  const char *path)
+{
+	const char *rest = path;
+	const char *name;
+	const char *alias = NULL;
+	uint32_t h = FNV_BASIS;
+	int pos = -1;
+	int offset;
+	int len;
+
+	if (!idx)
+		return fdt_path_offset(fdt, path);
+
+	/* A path starting with an alias is hashed as though it were written
+	 * out in full */
+	if (*path != '/') {
+		rest = strchr(path, '/');
+
+		if (!rest)
+			rest = path + strlen(path);
+
+		alias = fdt_index_get_alias_namelen(fdt, idx, path,
+						    rest - path);
+
+		if (!alias)
+			return -FDT_ERR_BADPATH;
+
+		h = fdt_index_hash_(h, alias, strlen(alias));
+	}
+
+	h = fdt_index_hash_(h, rest, strlen(rest));
+	name = fdt_index_basename_(*rest ? rest : alias);
+
+	/* Only the hash of the path is kept, so check that the node found has
+	 * the right name at least */
+	while ((offset = fdt_index_next_(idx, FDT_INDEX_PATHS, h, &pos)) >= 0) {
+		const char *p = fdt_get_name(fdt, offset, &len);
+
+		if (p && len == (int)strlen(name) && memcmp(p, name, len) == 0)
+			return offset;
+	}
+
+	return fdt_path_offset(fdt, path);
+}
+
+const char *fdt_index_get_alias_namelen(const void *fdt,
+					const struct fdt_index *idx,
+					const char *name, int namelen)
+{
+	const char *prop_name;
+	const char *value;
+	uint32_t h;
+	int pos = -1;
+	int offset;
+	int len;
+
+	if (!idx)
+		return fdt_get_alias_namelen(fdt, name, namelen);
+
+	h = fdt_index_hash_(FNV_BASIS, name, namelen);
+
+	while ((offset = fdt_index_next_(idx, FDT_INDEX_ALIASES, h, &pos)) >= 0) {
+		value = fdt_getprop_by_offset(fdt, offset, &prop_name, &len);
+
+		if (value && strlen(prop_name) == (size_t)namelen &&
+		    memcmp(prop_name, name, namelen) == 0)
+			return value;
+	}
+
+	/* Every alias is in the index */
+	return NULL;
+}
+
+const char *fdt_index_get_alias(const void *fdt, const struct fdt_index *idx,
+				const char *name)
+{
+	return fdt_index_get_alias_namelen(fdt, idx, name, strlen(name));
+}
+
+int fdt_index_node_offset_by_compatible(const void *fdt,
+					const struct fdt_index *idx,
+					int startoffset, const char *compatible)
+{
+	uint32_t h;
+	int pos = -1;
+	int offset;
+	int found = -FDT_ERR_NOTFOUND;
+
+	if (!idx)
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	h = fdt_index_hash_(FNV_BASIS, compatible, strlen(compatible));
+
+	/* Nodes sharing a compatible string have a slot each, in no
+	 * particular order, so find the first after startoffset */
+	while ((offset = fdt_index_next_(idx, FDT_INDEX_COMPATIBLES, h,
+					 &pos)) >= 0) {
+		if (offset > startoffset &&
+		    (found < 0 || offset < found) &&
+		    fdt_node_check_compatible(fdt, offset, compatible) == 0)
+			found = offset;
+	}
+
+	return found;
+}
+
+int fdt_index_node_offset_by_phandle(const void *fdt,
+				     const struct fdt_index *idx,
+				     uint32_t phandle)
+{
+	int pos = -1;
+	int offset;
+
+	if (!idx)
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	if ((phandle == 0) || (phandle == ~0U))
+		return -FDT_ERR_BADPHANDLE;
+
+	offset = fdt_index_next_(idx, FDT_INDEX_PHANDLES, phandle, &pos);
+
+	if (offset >= 0 && fdt_get_phandle(fdt, offset) == phandle)
+		return offset;
+
+	return -FDT_ERR_NOTFOUND;
+}
@@ -0,0 +1,143 @@
+#ifndef FDT_INDEX_H
+#define FDT_INDEX_H
+/*
+ * Lookup index for devicetree blobs in ROM
+ *
+ * make_image.py places an index straight after the devicetree blob in a ROM
+ * image, which maps node paths, aliases, compatible strings and phandles to
+ * node offsets through hash tables (see fdtindex.py in COMET68k_bootloader
+ * for the layout). The functions below are the same as the libfdt functions
+ * of the same name without "index_", but take the index found by
+ * fdt_index_get() and go straight to the node, rather than walking the whole
+ * structure block. Given a NULL index, they walk the blob as usual.
+ *
+ * Nothing marks a blob as having an index, so the caller must say how much
+ * memory follows the blob, such as the size of the ROM partition it is in.
+ * The header of a blob copied with fdt_open_into() gives the size of the
+ * buffer it was copied into, so there is no index to find in such a copy.
+ *
+ * The index is only valid for the blob it was built from, so must not be used
+ * once the blob has been changed.
+ */
+
+#include <libfdt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FDT_INDEX_MAGIC		0x46445449	/* "FDTI" */
+#define FDT_INDEX_VERSION	1
+#define FDT_INDEX_EMPTY		0xffffffff
+
+/* Tables of the index */
+#define FDT_INDEX_PATHS		0
+#define FDT_INDEX_ALIASES	1
+#define FDT_INDEX_COMPATIBLES	2
+#define FDT_INDEX_PHANDLES	3
+#define FDT_INDEX_TABLES	4
+
+struct fdt_index_slot {
+	fdt32_t key;			/* FNV-1a hash, or phandle */
+	fdt32_t value;			/* Node or property offset */
+};
+
+struct fdt_index {
+	fdt32_t magic;
+	fdt16_t version;
+	fdt16_t reserved;
+	fdt32_t totalsize;		/* Of the blob indexed */
+	fdt32_t size_dt_struct;
+	struct {
+		fdt32_t offset;		/* From the start of the index */
+		fdt32_t slots;		/* A power of 2 */
+	} table[FDT_INDEX_TABLES];
+};
+
+/**
+ * fdt_index_get - find the index of a blob
+ * @fdt: pointer to the device tree blob
+ * @avail: bytes that may be read from fdt, such as the size of the ROM
+ *         partition holding the blob and its index
+ *
+ * Nothing beyond @avail bytes from @fdt is read, here or by lookups given
+ * the index returned.
+ *
+ * returns:
+ *	pointer to the index that follows the blob, or NULL if there is none,
+ *	it does not fit in @avail bytes or it was not built for this blob
+ */
+const struct fdt_index *fdt_index_get(const void *fdt, size_t avail);
+
+/**
+ * fdt_index_path_offset - find a tree node by its full path
+ * @fdt: pointer to the device tree blob
+ * @idx: index of the blob from fdt_index_get(), or NULL
+ * @path: full path of the node to locate
+ *
+ * As fdt_path_offset(). The index holds full paths including unit
+ * addresses, and paths may start with an alias. Paths that omit unit
+ * addresses are not in the index, and are found by walking the blob.
+ */
+int fdt_index_path_offset(const void *fdt, const struct fdt_index *idx,
+			  const char *path);
+
+/**
+ * fdt_index_get_alias_namelen - get alias based on substring
+ * @fdt: pointer to the device tree blob
+ * @idx: index of the blob from fdt_index_get(), or NULL
+ * @name: name of the alias to look up
+ * @namelen: number of characters of name to consider
+ *
+ * As fdt_get_alias_namelen().
+ */
+const char *fdt_index_get_alias_namelen(const void *fdt,
+					const struct fdt_index *idx,
+					const char *name, int namelen);
+
+/**
+ * fdt_index_get_alias - retrieve the path referenced by a given alias
+ * @fdt: pointer to the device tree blob
+ * @idx: index of the blob from fdt_index_get(), or NULL
+ * @name: name of the alias to look up
+ *
+ * As fdt_get_alias().
+ */
+const char *fdt_index_get_alias(const void *fdt, const struct fdt_index *idx,
+				const char *name);
+
+/**
+ * fdt_index_node_offset_by_compatible - find nodes with a given
+ *                                       'compatible' value
+ * @fdt: pointer to the device tree blob
+ * @idx: index of the blob from fdt_index_get(), or NULL
+ * @startoffset: only find nodes after this offset, or -1 to start at the
+ *               beginning
+ * @compatible: 'compatible' string to match against
+ *
+ * As fdt_node_offset_by_compatible(). Each node found is checked with
+ * fdt_node_check_compatible(), and as every compatible string of the
+ * blob is in the index, a string that is not found there is not in the
+ * blob.
+ */
+int fdt_index_node_offset_by_compatible(const void *fdt,
+					const struct fdt_index *idx,
+					int startoffset, const char *compatible);
+
+/**
+ * fdt_index_node_offset_by_phandle - find the node with a given phandle
+ * @fdt: pointer to the device tree blob
+ * @idx: index of the blob from fdt_index_get(), or NULL
+ * @phandle: phandle value
+ *
+ * As fdt_node_offset_by_phandle().
+ */
+int fdt_index_node_offset_by_phandle(const void *fdt,
+				     const struct fdt_index *idx,
+				     uint32_t phandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FDT_INDEX_H */
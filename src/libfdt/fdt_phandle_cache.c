@@ -0,0 +1,135 @@
+/*
+ * Phandle to node offset cache, see fdt_phandle_cache.h
+ */
+#include "libfdt_env.h"
+
+#include <fdt.h>
+#include <libfdt.h>
+
+#include "libfdt_internal.h"
+#include "fdt_phandle_cache.h"
+
+/* Caches to mark as stale when their blob changes */
+static struct fdt_phandle_cache *fdt_phandle_caches_;
+
+static int fdt_phandle_cache_build_(struct fdt_phandle_cache *cache,
+				    const void *fdt)
+{
+	struct fdt_phandle_entry *entries = cache->entries;
+	uint32_t phandle;
+	int count = 0;
+	int offset;
+	int i;
+
+	cache->fdt = fdt;
+	cache->stale = 0;
+
+	for (offset = fdt_next_node(fdt, -1, NULL);
+	     offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		phandle = fdt_get_phandle(fdt, offset);
+
+		if (phandle == 0 || phandle == ~0U)
+			continue;
+
+		/* dtc numbers phandles in the order of their nodes, so each
+		 * usually goes straight on the end. Where a phandle is used
+		 * twice, the first node has it, as with
+		 * fdt_node_offset_by_phandle(). */
+		for (i = count; i > 0 && entries[i - 1].phandle > phandle; i--)
+			;
+
+		if (i > 0 && entries[i - 1].phandle == phandle)
+			continue;
+
+		if (count == cache->max) {
+			cache->count = -FDT_ERR_NOSPACE;
+			return cache->count;
+		}
+
+		memmove(&entries[i + 1], &entries[i],
+			(count - i) * sizeof(entries[0]));
+		entries[i].phandle = phandle;
+		entries[i].offset = offset;
+		count++;
+	}
+
+	if (offset != -FDT_ERR_NOTFOUND)
+		count = offset;
+
+	cache->count = count;
+
+	return count;
+}
+
+int fdt_phandle_cache_init(struct fdt_phandle_cache *cache, const void *fdt,
+			   struct fdt_phandle_entry *entries, int max)
+{
+	FDT_RO_PROBE(fdt);
+
+	fdt_phandle_cache_release(cache);
+
+	cache->entries = entries;
+	cache->max = max;
+	cache->next = fdt_phandle_caches_;
+	fdt_phandle_caches_ = cache;
+
+	return fdt_phandle_cache_build_(cache, fdt);
+}
+
+int fdt_phandle_cache_lookup(struct fdt_phandle_cache *cache,
+			     const void *fdt, uint32_t phandle)
+{
+	const struct fdt_phandle_entry *entries = cache->entries;
+	int low = 0;
+	int high;
+	int mid;
+
+	if ((phandle == 0) || (phandle == ~0U))
+		return -FDT_ERR_BADPHANDLE;
+
+	if (cache->fdt != fdt || cache->stale)
+		fdt_phandle_cache_build_(cache, fdt);
+
+	if (cache->count < 0)
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	high = cache->count;
+
+	while (low < high) {
+		mid = (low + high) >> 1;
+
+		if (entries[mid].phandle < phandle)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low < cache->count && entries[low].phandle == phandle)
+		return entries[low].offset;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+void fdt_phandle_cache_invalidate(const void *fdt)
+{
+	struct fdt_phandle_cache *cache;
+
+	for (cache = fdt_phandle_caches_; cache; cache = cache->next)
+		if (cache->fdt == fdt)
+			cache->stale = 1;
+}
+
+void fdt_phandle_cache_release(struct fdt_phandle_cache *cache)
+{
+	struct fdt_phandle_cache **p;
+
+	for (p = &fdt_phandle_caches_; *p; p = &(*p)->next) {
+		if (*p == cache) {
+			*p = cache->next;
+			break;
+		}
+	}
+
+	cache->fdt = NULL;
+}
@@ -0,0 +1,98 @@
+#ifndef FDT_PHANDLE_CACHE_H
+#define FDT_PHANDLE_CACHE_H
+/*
+ * Phandle to node offset cache
+ *
+ * fdt_node_offset_by_phandle() walks the whole blob for each phandle, so
+ * resolving the interrupt-parent and other references of every node takes
+ * time in the square of the size of the tree. A cache maps each phandle of a
+ * blob to the offset of its node, in a sorted array supplied by the caller,
+ * which is then searched in O(log n).
+ *
+ * The cache is built from the blob once, and again after the blob has been
+ * changed. Every change made through fdt_rw.c or fdt_wip.c marks the caches of
+ * that blob as stale, and a stale cache is rebuilt by the next lookup. A blob
+ * changed by any other means must be passed to fdt_phandle_cache_invalidate().
+ * A cache that turns out to be too small for the blob leaves lookups to
+ * fdt_node_offset_by_phandle().
+ */
+
+#include <libfdt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fdt_phandle_entry {
+	uint32_t phandle;
+	int offset;
+};
+
+struct fdt_phandle_cache {
+	const void *fdt;		/* Blob the cache was built from */
+	struct fdt_phandle_entry *entries;	/* Sorted by phandle */
+	int max;			/* Entries there is room for */
+	int count;			/* Entries used, or a libfdt error */
+	int stale;			/* The blob has changed since */
+	struct fdt_phandle_cache *next;	/* Caches in use */
+};
+
+/**
+ * fdt_phandle_cache_init - build a phandle cache for a blob
+ * @cache: cache to build
+ * @fdt: pointer to the device tree blob
+ * @entries: array to hold the cache
+ * @max: number of entries in the array
+ *
+ * Builds the cache and keeps it up to date with the blob from then on,
+ * until fdt_phandle_cache_release(). For a blob built by dtc, whose
+ * phandles are numbered from 1, fdt_get_max_phandle() gives the number of
+ * entries needed.
+ *
+ * returns:
+ *	number of entries used, on success
+ *	-FDT_ERR_NOSPACE, the blob has more than max phandles
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_phandle_cache_init(struct fdt_phandle_cache *cache, const void *fdt,
+			   struct fdt_phandle_entry *entries, int max);
+
+/**
+ * fdt_phandle_cache_lookup - find the node with a given phandle
+ * @cache: cache built with fdt_phandle_cache_init()
+ * @fdt: pointer to the device tree blob
+ * @phandle: phandle value
+ *
+ * As fdt_node_offset_by_phandle(). The cache is first rebuilt if it is
+ * stale, or was built from another blob, e.g. before the blob was moved with
+ * fdt_open_into().
+ */
+int fdt_phandle_cache_lookup(struct fdt_phandle_cache *cache,
+			     const void *fdt, uint32_t phandle);
+
+/**
+ * fdt_phandle_cache_invalidate - mark the caches of a blob as stale
+ * @fdt: pointer to the device tree blob
+ *
+ * Called by the functions of fdt_rw.c and fdt_wip.c which change a blob, and
+ * to be called after changing a blob by any other means.
+ */
+void fdt_phandle_cache_invalidate(const void *fdt);
+
+/**
+ * fdt_phandle_cache_release - stop keeping a cache up to date
+ * @cache: cache built with fdt_phandle_cache_init()
+ *
+ * Must be called before the cache, or its array, goes out of scope.
+ */
+void fdt_phandle_cache_release(struct fdt_phandle_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FDT_PHANDLE_CACHE_H */
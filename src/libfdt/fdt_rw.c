@@ -9,6 +9,7 @@
 #include <libfdt.h>
 
 #include "libfdt_internal.h"
+#include "fdt_phandle_cache.h"
 
 static int fdt_blocks_misordered_(const void *fdt,
 				  int mem_rsv_size, int struct_size)
@@ -24,6 +25,9 @@ static int fdt_blocks_misordered_(const void *fdt,
 
 static int fdt_rw_probe_(void *fdt)
 {
+	/* Every change to the blob starts here */
+	fdt_phandle_cache_invalidate(fdt);
+
 	if (can_assume(VALID_DTB))
 		return 0;
 	FDT_RO_PROBE(fdt);
@@ -426,6 +430,7 @@ int fdt_open_into(const void *fdt, void *buf, int bufsize)
 	char *tmp;
 
 	FDT_RO_PROBE(fdt);
+	fdt_phandle_cache_invalidate(buf);
 
 	mem_rsv_size = (fdt_num_mem_rsv(fdt)+1)
 		* sizeof(struct fdt_reserve_entry);
@@ -9,6 +9,7 @@
 #include <libfdt.h>
 
 #include "libfdt_internal.h"
+#include "fdt_phandle_cache.h"
 
 int fdt_setprop_inplace_namelen_partial(void *fdt, int nodeoffset,
 					const char *name, int namelen,
@@ -26,6 +27,7 @@ int fdt_setprop_inplace_namelen_partial(void *fdt, int nodeoffset,
 	if ((unsigned)proplen < (len + idx))
 		return -FDT_ERR_NOSPACE;
 
+	fdt_phandle_cache_invalidate(fdt);
 	memcpy((char *)propval + idx, val, len);
 	return 0;
 }
@@ -48,10 +50,12 @@ int fdt_setprop_inplace(void *fdt, int nodeoffset, const char *name,
 						   val, len);
 }
 
-static void fdt_nop_region_(void *start, int len)
+static void fdt_nop_region_(void *fdt, void *start, int len)
 {
 	fdt32_t *p;
 
+	fdt_phandle_cache_invalidate(fdt);
+
 	for (p = start; (char *)p < ((char *)start + len); p++)
 		*p = cpu_to_fdt32(FDT_NOP);
 }
@@ -65,7 +69,7 @@ int fdt_nop_property(void *fdt, int nodeoffset, const char *name)
 	if (!prop)
 		return len;
 
-	fdt_nop_region_(prop, len + sizeof(*prop));
+	fdt_nop_region_(fdt, prop, len + sizeof(*prop));
 
 	return 0;
 }
@@ -88,7 +92,7 @@ int fdt_nop_node(void *fdt, int nodeoffset)
 	if (endoffset < 0)
 		return endoffset;
 
-	fdt_nop_region_(fdt_offset_ptr_w(fdt, nodeoffset, 0),
+	fdt_nop_region_(fdt, fdt_offset_ptr_w(fdt, nodeoffset, 0),
 			endoffset - nodeoffset);
 	return 0;
 }
@@ -129,12 +129,17 @@ uint32_t fdt_next_tag(const void *fdt, int offset, int *nextoffset);
 /*
  * External helpers to access words from a device tree blob. They're built
  * to work even with unaligned pointers on platforms (such as ARMv5) that don't
- * like unaligned loads and stores.
+ * like unaligned loads and stores. Where the CPU is big-endian, aligned words
+ * are loaded and stored whole (see libfdt_env.h).
  */
 static inline uint16_t fdt16_ld(const fdt16_t *p)
 {
 	const uint8_t *bp = (const uint8_t *)p;
 
+#ifdef FDT_NATIVE_ENDIAN
+	if (FDT_ALIGNED(p, 2))
+		return *p;
+#endif
 	return ((uint16_t)bp[0] << 8) | bp[1];
 }
 
@@ -142,6 +147,10 @@ static inline uint32_t fdt32_ld(const fdt32_t *p)
 {
 	const uint8_t *bp = (const uint8_t *)p;
 
+#ifdef FDT_NATIVE_ENDIAN
+	if (FDT_ALIGNED(p, 4))
+		return *p;
+#endif
 	return ((uint32_t)bp[0] << 24)
 		| ((uint32_t)bp[1] << 16)
 		| ((uint32_t)bp[2] << 8)
@@ -152,6 +161,12 @@ static inline void fdt32_st(void *property, uint32_t value)
 {
 	uint8_t *bp = (uint8_t *)property;
 
+#ifdef FDT_NATIVE_ENDIAN
+	if (FDT_ALIGNED(property, 4)) {
+		*(fdt32_t *)property = value;
+		return;
+	}
+#endif
 	bp[0] = value >> 24;
 	bp[1] = (value >> 16) & 0xff;
 	bp[2] = (value >> 8) & 0xff;
@@ -162,6 +177,11 @@ static inline uint64_t fdt64_ld(const fdt64_t *p)
 {
 	const uint8_t *bp = (const uint8_t *)p;
 
+#ifdef FDT_NATIVE_ENDIAN
+	if (FDT_ALIGNED(p, 8))
+		return ((uint64_t)fdt32_ld((const fdt32_t *)p) << 32) |
+			fdt32_ld((const fdt32_t *)p + 1);
+#endif
 	return ((uint64_t)bp[0] << 56)
 		| ((uint64_t)bp[1] << 48)
 		| ((uint64_t)bp[2] << 40)
@@ -176,6 +196,13 @@ static inline void fdt64_st(void *property, uint64_t value)
 {
 	uint8_t *bp = (uint8_t *)property;
 
+#ifdef FDT_NATIVE_ENDIAN
+	if (FDT_ALIGNED(property, 8)) {
+		fdt32_st(property, value >> 32);
+		fdt32_st((fdt32_t *)property + 1, value);
+		return;
+	}
+#endif
 	bp[0] = value >> 56;
 	bp[1] = (value >> 48) & 0xff;
 	bp[2] = (value >> 40) & 0xff;
@@ -26,6 +26,57 @@ typedef uint16_t FDT_BITWISE fdt16_t;
 typedef uint32_t FDT_BITWISE fdt32_t;
 typedef uint64_t FDT_BITWISE fdt64_t;
 
+/*
+ * Values in the blob are big-endian, which on a big-endian CPU such as the
+ * 68000 is already the order they are used in, so they need no converting at
+ * all. Define FDT_NO_NATIVE_ENDIAN to convert them a byte at a time anyway,
+ * e.g. to compare the two.
+ */
+#if !defined(FDT_NO_NATIVE_ENDIAN) && \
+    ((defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) || \
+     defined(__m68k__))
+#define FDT_NATIVE_ENDIAN
+#endif
+
+/*
+ * Whether p is aligned well enough to load or store size bytes at once, for
+ * fdtXX_ld() and fdtXX_st() in libfdt.h. The 68000 and 68010 only need word
+ * alignment, even for longs, and fault on an odd address.
+ */
+#ifdef __m68k__
+#define FDT_ALIGNED(p, size)	(((uintptr_t)(p) & 1) == 0)
+#else
+#define FDT_ALIGNED(p, size)	(((uintptr_t)(p) & ((size) - 1)) == 0)
+#endif
+
+#ifdef FDT_NATIVE_ENDIAN
+static inline uint16_t fdt16_to_cpu(fdt16_t x)
+{
+	return (FDT_FORCE uint16_t)x;
+}
+static inline fdt16_t cpu_to_fdt16(uint16_t x)
+{
+	return (FDT_FORCE fdt16_t)x;
+}
+
+static inline uint32_t fdt32_to_cpu(fdt32_t x)
+{
+	return (FDT_FORCE uint32_t)x;
+}
+static inline fdt32_t cpu_to_fdt32(uint32_t x)
+{
+	return (FDT_FORCE fdt32_t)x;
+}
+
+static inline uint64_t fdt64_to_cpu(fdt64_t x)
+{
+	return (FDT_FORCE uint64_t)x;
+}
+static inline fdt64_t cpu_to_fdt64(uint64_t x)
+{
+	return (FDT_FORCE fdt64_t)x;
+}
+#else
 #define EXTRACT_BYTE(x, n)	((unsigned long long)((uint8_t *)&x)[n])
 #define CPU_TO_FDT16(x) ((EXTRACT_BYTE(x, 0) << 8) | EXTRACT_BYTE(x, 1))
 #define CPU_TO_FDT32(x) ((EXTRACT_BYTE(x, 0) << 24) | (EXTRACT_BYTE(x, 1) << 16) | \
@@ -65,6 +116,7 @@ static inline fdt64_t cpu_to_fdt64(uint64_t x)
 #undef CPU_TO_FDT32
 #undef CPU_TO_FDT16
 #undef EXTRACT_BYTE
+#endif /* FDT_NATIVE_ENDIAN */
 
 #ifdef __APPLE__
 #include <AvailabilityMacros.h>